@@ -193,6 +193,7 @@ static void GPRSProgress(char * data)
 	setfont("");
 	gotoxy(1, 1);
 	putpixelcol(data, 12);
+	DispInvalidate();
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -1974,6 +1975,44 @@ uint CommsDisconnect(T_COMMS * psComms)
 	return ERR_COMMS_NONE;
 }
 
+/*
+**-----------------------------------------------------------------------------
+** FUNCTION   : CommsIdleCheck
+**
+** DESCRIPTION: Check that an idle TCP connection kept open for reuse is still usable.
+**				The host must not have closed it or sent anything since the last exchange
+**
+** PARAMETERS:	psComms		<=	Communication structure holding the connection handle
+**
+** RETURNS:		ERR_COMMS_NONE if the connection can be reused
+**				ERR_COMMS_NOT_CONNECTED otherwise
+**
+**-----------------------------------------------------------------------------
+*/
+static uint CommsIdleCheck(T_COMMS * psComms)
+{
+	int numOfBytes = 0;
+	char byte;
+	struct timeval timeout;
+
+	if (psComms->eConnectionType != E_CONNECTION_TYPE_IP || psComms->wHandle == 0xFFFF || iphandle < 0)
+		return ERR_COMMS_NOT_CONNECTED;
+
+	// Anything left over from a previous exchange would be taken as part of the next response
+	if (ioctlsocket(psComms->wHandle, FIONREAD, &numOfBytes) < 0 || numOfBytes)
+		return ERR_COMMS_NOT_CONNECTED;
+
+	// With nothing waiting, a read that does not time out means the host has closed the connection
+	timeout.tv_sec = 0;
+	timeout.tv_usec = 1;
+	setsockopt(psComms->wHandle, SOL_SOCKET, SO_RCVTIMEO, (char*)&timeout, sizeof(timeout));
+	setsockopt(psComms->wHandle, SOL_SOCKET, SO_PKTRCVTIMEO, (char*)&timeout, sizeof(timeout));
+	if (recv(psComms->wHandle, &byte, 1, 0) >= 0 || CommsTranslateError(errno) != ERR_COMMS_TIMEOUT)
+		return ERR_COMMS_NOT_CONNECTED;
+
+	return ERR_COMMS_NONE;
+}
+
 /*
 **-----------------------------------------------------------------------------
 ** FUNCTION   : Comms
@@ -2201,6 +2240,8 @@ uint Comms(E_COMMS_FUNC eFunc, T_COMMS * psComms, ...)
 			return 0;
 		case E_COMMS_FUNC_PING:
 			return ping(psComms->ipAddress);
+		case E_COMMS_FUNC_IDLE_CHECK:
+			return CommsIdleCheck(psComms);
 	}
 
 	return ERR_COMMS_FUNC_NOT_SUPPORTED;
@@ -34,6 +34,7 @@
 ** Local include files
 */
 #include "auris.h"
+#include "alloc.h"
 #include "comms.h"
 #include "display.h"
 
@@ -42,6 +43,18 @@
 ** Constants
 **-----------------------------------------------------------------------------
 */
+#define	C_SHADOW_ROWS			16		// 6x8 font rows kept in the shadow buffer. Anything written below is not tracked
+#define	C_SHADOW_ROWS_LARGE		8		// 8x16 font rows
+
+#define	C_CELL_UNKNOWN			0		// Not known what is on the screen there
+#define	C_CELL_NORMAL			1
+#define	C_CELL_INVERSE			2
+
+#define	C_FONT_SMALL			0x01
+#define	C_FONT_LARGE			0x02
+#define	C_FONT_ALL				(C_FONT_SMALL | C_FONT_LARGE)
+
+#define	C_GRAPHICS_ROW			126		// Pixel columns of a converted 8 pixel high image row
 
 /*
 **-----------------------------------------------------------------------------
@@ -50,6 +63,81 @@
 */
 extern int conHandle;
 
+// Shadow of the text on the screen for each font so only the characters that change are written
+typedef struct
+{
+	char text[MAX_COL];
+	uchar attr[MAX_COL];		// C_CELL_xxx
+} T_SHADOW_ROW;
+
+static T_SHADOW_ROW shadow[C_SHADOW_ROWS];
+static T_SHADOW_ROW shadowLarge[C_SHADOW_ROWS_LARGE];
+
+// The last image displayed, kept rotated to the display format
+static uchar * lastGraphics = NULL;
+static uint lastGraphicsLength = 0;
+static char * lastGraphicsPixels = NULL;
+static uint lastGraphicsRow = 0;
+static uint lastGraphicsHeight = 0;
+static bool lastGraphicsShown = false;
+
+/*
+**-----------------------------------------------------------------------------
+** FUNCTION   : DispForget
+**
+** DESCRIPTION: Marks an area of the screen as unknown after it has been written to
+**				without going through the shadow buffer
+**
+** PARAMETERS:	row			<=	First 6x8 font row (pixel row / 8)
+**				rows		<=	Number of 6x8 font rows
+**				pixel		<=	First pixel column
+**				pixels		<=	Number of pixel columns
+**				fonts		<=	The shadow buffers affected. C_FONT_xxx
+**
+** RETURNS:		None
+**
+**-----------------------------------------------------------------------------
+*/
+static void DispForget(uint row, uint rows, uint pixel, uint pixels, uchar fonts)
+{
+	uint i, j;
+
+	for (i = row; (fonts & C_FONT_SMALL) && i < row + rows && i < C_SHADOW_ROWS; i++)
+	{
+		for (j = pixel / 6; j < (pixel + pixels + 5) / 6 && j < MAX_COL; j++)
+			shadow[i].attr[j] = C_CELL_UNKNOWN;
+	}
+
+	for (i = row / 2; (fonts & C_FONT_LARGE) && i < (row + rows + 1) / 2 && i < C_SHADOW_ROWS_LARGE; i++)
+	{
+		for (j = pixel / 8; j < (pixel + pixels + 7) / 8 && j < MAX_COL_LARGE_FONT; j++)
+			shadowLarge[i].attr[j] = C_CELL_UNKNOWN;
+	}
+
+	if (lastGraphicsShown && row < lastGraphicsRow + lastGraphicsHeight && lastGraphicsRow < row + rows)
+		lastGraphicsShown = false;
+}
+
+/*
+**-----------------------------------------------------------------------------
+** FUNCTION   : DispInvalidate
+**
+** DESCRIPTION: Forget what is on the screen. Must be called after writing to the
+**				console directly. The next displays are written in full.
+**
+** PARAMETERS:	None
+**
+** RETURNS:		None
+**
+**-----------------------------------------------------------------------------
+*/
+void DispInvalidate(void)
+{
+	memset(shadow, C_CELL_UNKNOWN, sizeof(shadow));
+	memset(shadowLarge, C_CELL_UNKNOWN, sizeof(shadowLarge));
+	lastGraphicsShown = false;
+}
+
 /*
 **-----------------------------------------------------------------------------
 ** FUNCTION   : DispInit
@@ -64,8 +152,12 @@ extern int conHandle;
 */
 void DispInit(void)
 {
+	// Another task may have drawn on the console while it was given away so nothing on the screen is known
 	if (conHandle == -1)
+	{
 		conHandle = open(DEV_CONSOLE, 0);
+		DispInvalidate();
+	}
 }
 
 /*
@@ -82,11 +174,22 @@ void DispInit(void)
 */
 void DispClearScreen(void)
 {
+	int i;
+
 	// Initialisation
 	DispInit();
 
 	clrscr();
 
+	// The screen is now known to be blank
+	memset(shadow, ' ', sizeof(shadow));
+	memset(shadowLarge, ' ', sizeof(shadowLarge));
+	for (i = 0; i < C_SHADOW_ROWS; i++)
+		memset(shadow[i].attr, C_CELL_NORMAL, MAX_COL);
+	for (i = 0; i < C_SHADOW_ROWS_LARGE; i++)
+		memset(shadowLarge[i].attr, C_CELL_NORMAL, MAX_COL_LARGE_FONT);
+	lastGraphicsShown = false;
+
 //#ifdef __VMAC
 #if 0
 	DispText("Dev lock mode", 0, 0, true, false, true);
@@ -115,42 +218,86 @@ void DispClearScreen(void)
 void DispText(char * text, uint row, uint col, bool clearLine, bool largeFont, bool inverse)
 {
 	const char * emptyLine = "                     ";
+	uint width = largeFont?MAX_COL_LARGE_FONT:MAX_COL;
+	uint length = strlen(text);
+	T_SHADOW_ROW * line;
+	char newText[MAX_COL];
+	uchar newAttr[MAX_COL];
+	uchar attr = inverse?C_CELL_INVERSE:C_CELL_NORMAL;
+	int first, last;
 
 	// Initialisation
 	DispInit();
 
 	// If centre requested
 	if (col == 255)
-		col = ((largeFont?MAX_COL_LARGE_FONT:MAX_COL) - strlen(text)) / 2;
+		col = (width - length) / 2;
 
 	// If right justificatino requested
 	else if  (col == 254)
 	{
-		col = (largeFont?MAX_COL_LARGE_FONT:MAX_COL) - strlen(text);
+		col = width - length;
 	}
 
-	if (!largeFont)
+	// Text written at the cursor or outside the shadow buffer is written as it is
+	if (row == 9999 || row >= (largeFont?C_SHADOW_ROWS_LARGE:C_SHADOW_ROWS) || col >= width || col + length > width)
 	{
-		inverse?setfont("f:asc8x21i.vft"):setfont("");
-		if (row == 9999)
-			write(conHandle, text, strlen(text));
+		if (!largeFont)
+			inverse?setfont("f:asc8x21i.vft"):setfont("");
 		else
+			inverse?setfont("f:ir8x16i.vft"):setfont("f:ir8x16.vft");
+
+		if (row == 9999)
 		{
-			if (clearLine) write_at(emptyLine, 21, 1, row+1);
-			write_at(text, strlen(text), col+1, row+1);
+			write(conHandle, text, strlen(text));
+			DispInvalidate();
+			return;
 		}
+
+		if (clearLine) write_at(emptyLine, width, 1, row+1);
+		write_at(text, strlen(text), col+1, row+1);
+
+		if (largeFont)
+			DispForget(row * 2, 2, clearLine?0:col*8, clearLine?width*8:length*8, C_FONT_ALL);
+		else
+			DispForget(row, 1, clearLine?0:col*6, clearLine?width*6:length*6, C_FONT_ALL);
+		return;
 	}
-	else
+
+	// Work out what the line should look like
+	line = largeFont?&shadowLarge[row]:&shadow[row];
+	memcpy(newText, line->text, width);
+	memcpy(newAttr, line->attr, width);
+	if (clearLine)
 	{
-		inverse?setfont("f:ir8x16i.vft"):setfont("f:ir8x16.vft");
-		if (row == 9999)
-			write(conHandle, text, strlen(text));
-		else
-		{
-			if (clearLine) write_at(emptyLine, 16, 1, row+1);
-			write_at(text, strlen(text), col+1, row+1);
-		}
+		memset(newText, ' ', width);
+		memset(newAttr, attr, width);
 	}
+	memcpy(&newText[col], text, length);
+	memset(&newAttr[col], attr, length);
+
+	// Only write the characters that differ from what is on the screen
+	for (first = 0; first < (int) width && newAttr[first] == line->attr[first] && newText[first] == line->text[first]; first++);
+	if (first == (int) width)
+		return;
+	for (last = width - 1; newAttr[last] == line->attr[last] && newText[last] == line->text[last]; last--);
+
+	if (!largeFont)
+		inverse?setfont("f:asc8x21i.vft"):setfont("");
+	else
+		inverse?setfont("f:ir8x16i.vft"):setfont("f:ir8x16.vft");
+
+	// The characters differing all have the new attribute as the text and any cleared part of the line share it
+	write_at(&newText[first], last - first + 1, first+1, row+1);
+
+	memcpy(line->text, newText, width);
+	memcpy(line->attr, newAttr, width);
+
+	// The cells of the other font overlapping the ones written are no longer known
+	if (largeFont)
+		DispForget(row * 2, 2, first * 8, (last - first + 1) * 8, C_FONT_SMALL);
+	else
+		DispForget(row, 1, first * 6, (last - first + 1) * 6, C_FONT_LARGE);
 }
 
 /*
@@ -176,36 +323,61 @@ void DispGraphics(uchar * graphics, uint row, uint col)
 	int width = graphics[1]/8;
 	int widthchar = graphics[1]/6;
 	int height = graphics[3]/8;
+	uint length = 4 + width * height * 8;
 
 	// Initialisation
 	DispInit();
 
-	// Set font to 6x8 to achieve the best resolution. The other 2 are 8x16 or 16x16 which will
-	// give us a bad column resolution
-	setfont("");
+	if (height == 0)
+		return;
 
-	// Do the conversion and output. It must be multiples of 8 pixels in both directions unfortunately
-	// Paint as many rows as requested
-	for (m = 0; m < height; m++)
+	// The image is only converted if it is not the last one displayed. If it is still on the screen where it was displayed, there is nothing to do.
+	if (lastGraphics == NULL || lastGraphicsLength != length || memcmp(lastGraphics, graphics, length))
 	{
-		char data[126];
-
-		gotoxy((21 - widthchar)/2+1, row+1+m);
-		memset(data, 0, sizeof(data));
-
-		for (k = 0; k < width; k++)
+		if (lastGraphics) my_free(lastGraphics);
+		if (lastGraphicsPixels) my_free(lastGraphicsPixels);
+		lastGraphics = my_malloc(length);
+		memcpy(lastGraphics, graphics, length);
+		lastGraphicsLength = length;
+		lastGraphicsPixels = my_calloc(height * C_GRAPHICS_ROW);
+
+		// Do the conversion. It must be multiples of 8 pixels in both directions unfortunately
+		for (m = 0; m < height; m++)
 		{
-			for (bitmap = 0x80, j = 0; j < 8 && (j+k*8) < sizeof(data); j++, bitmap >>= 1)
+			char * data = &lastGraphicsPixels[m * C_GRAPHICS_ROW];
+
+			for (k = 0; k < width; k++)
 			{
-				for (i = 0; i < 8; i++)
+				for (bitmap = 0x80, j = 0; j < 8 && (j+k*8) < C_GRAPHICS_ROW; j++, bitmap >>= 1)
 				{
-					if (graphics[4 + i*width + k + m*width*8] & bitmap)
-						data[j + k*8] += (1 << i);
+					for (i = 0; i < 8; i++)
+					{
+						if (graphics[4 + i*width + k + m*width*8] & bitmap)
+							data[j + k*8] += (1 << i);
+					}
 				}
 			}
 		}
-		putpixelcol(data, k*8/6*6);
 	}
+	else if (lastGraphicsShown && lastGraphicsRow == row)
+		return;
+
+	// Set font to 6x8 to achieve the best resolution. The other 2 are 8x16 or 16x16 which will
+	// give us a bad column resolution
+	setfont("");
+
+	// Paint as many rows as requested
+	for (m = 0; m < height; m++)
+	{
+		gotoxy((21 - widthchar)/2+1, row+1+m);
+		putpixelcol(&lastGraphicsPixels[m * C_GRAPHICS_ROW], width*8/6*6);
+	}
+
+	// The image covers the full width of the rows
+	DispForget(row, height, 0, MAX_COL * 6, C_FONT_ALL);
+	lastGraphicsRow = row;
+	lastGraphicsHeight = height;
+	lastGraphicsShown = true;
 }
 
 #ifdef __VX670
@@ -240,6 +412,7 @@ void DispSignal(uint row, uint col)
 	memset(data, 0, sizeof(data));
 	
 	gotoxy(col + 1, row + 1);
+	DispForget(row, 1, col * 6, sizeof(data), C_FONT_ALL);
 
 	if (value == 0 || value > 32)
 		write_at("   ", 3, col+1, row+1);
@@ -332,6 +505,7 @@ char DebugDisp (const char *template, ...)
 
     setfont("");
     write_at(stmp, strlen(stmp), 1, 0);
+    DispInvalidate();
     while(read(STDIN, &key, 1) != 1);
     key &= 0x7F;
     if(old_mode)
@@ -39,6 +39,7 @@ extern int debug;
 
 #ifdef _DEBUG
 	#define	_remove	remove
+	#define	_rename	rename
 	#define STDIN 1
 	write_at(char * tempBuf, int length, int q, int w);
 	read(int x, char * y, int z);
@@ -64,6 +65,7 @@ extern int debug;
 	#define	FH_NEW					"wb"
 	#define	FH_RDWR					"r+b"
 	#define FH_NEW_RDWR				"w+b"
+	#define	FH_APPEND				"ab"
 
 	#define	open(fn,attr)			fopen(fn, attr)
 	#define	close(a)				fclose(a)
@@ -83,6 +85,7 @@ extern int debug;
 	#define	FH_NEW					(O_CREAT | O_TRUNC | O_WRONLY | O_APPEND)
 	#define	FH_RDWR					O_RDWR
 	#define FH_NEW_RDWR				(O_CREAT | O_TRUNC | O_RDWR)
+	#define	FH_APPEND				(O_CREAT | O_WRONLY | O_APPEND)
 
 	#define	FH_OK(h)				(h != -1)
 	#define	FH_ERR(h)				(h == -1)
@@ -134,7 +134,8 @@ typedef enum
 	E_COMMS_FUNC_PSTN_WAIT,
 	E_COMMS_FUNC_DISP_GPRS_STS,
 	E_COMMS_FUNC_SIGNAL_STRENGTH,
-	E_COMMS_FUNC_PING
+	E_COMMS_FUNC_PING,
+	E_COMMS_FUNC_IDLE_CHECK
 } E_COMMS_FUNC;
 
 typedef enum
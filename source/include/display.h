@@ -32,6 +32,7 @@
 //
 void DispInit(void);
 void DispClearScreen(void);
+void DispInvalidate(void);
 void DispText(char * text, unsigned int row, unsigned int col, unsigned char clearLine, unsigned char largeFont, unsigned char inverse);
 void DispGraphics(unsigned char * graphics, unsigned int row, unsigned int col);
 void DispSignal(uint row, uint col);
@@ -30,7 +30,7 @@ extern char irisGroup[];
 ** Type definitions
 **-----------------------------------------------------------------------------
 */
-typedef struct
+typedef struct T_TEMPDATA_S
 {
 	char * group;
 	char * name;
@@ -39,8 +39,19 @@ typedef struct
 					// bit 1: Write access by other groups allowed (.w)
 					// bit 2: Byte Array. (.h)
 					// bit 8: temp. Automatically deleted when IDLE display is current. (.t)
+	uint length;					// Length of a byte array value
+	uint hash;						// Hash of the name. The name, value and group strings follow the entry in the same allocation
+	struct T_TEMPDATA_S * next;		// Next temporary data of the same object bucket
+	struct T_TEMPDATA_S ** prev;	// The link pointing to this entry within the object bucket
 } T_TEMPDATA;
 
+typedef struct
+{
+	ulong buckets;		// Data change counters of the objects read. See IRIS_TrackDependencies()
+	ulong generation;	// Sum of those counters when the values were resolved
+	bool changing;		// A function that changes on its own (eg. ()TIME) was used or data was changed while resolving
+} T_DEPENDENCY;
+
 extern char * currentObject;
 extern char * currentObjectData;
 extern uint currentObjectLength;
@@ -83,14 +94,30 @@ char * getLastKeyDesc(unsigned char key, T_KEYBITMAP * keyBitmap);
 */
 // Push a simple string value onto the stack if stack available
 void IRIS_StackPush(char * value);
+
+// Push a value onto the stack without copying it into a new string. A constant must outlive its stack slot. A blob reads as ASCII hex text
+void IRIS_StackPushConst(const char * value);
+void IRIS_StackPushNumber(long value);
+void IRIS_StackPushBlob(char * value, uint length);
+void IRIS_StackPushBlobConst(char * value, uint length);
+void IRIS_StackPushAllocatedBlob(char * value, uint length);
+void IRIS_StackPushPointer(void * value);
 bool IRIS_StackPushFunc(char * function);
 
+// Returns the operation (irisFunc[].op) of the function being executed
+uchar IRIS_FuncOp(void);
+
 // Pop "count" values from the top of the stack
 void IRIS_StackPop(int count);
 
 // Examine a stack value offseted by "offset" from the top of the stack
 char * IRIS_StackGet(char offset);
 
+// Examine a stack value as a number, as bytes (ASCII hex text is converted) or as an array of arrays handle (NULL if not pushed as one)
+long IRIS_StackGetNumber(char offset);
+char * IRIS_StackGetBytes(char offset, uint * length);
+void * IRIS_StackGetPointer(char offset);
+
 // Flushes the stack and deallocates all memory used within the stack
 void IRIS_StackFlush(void);
 
@@ -108,18 +135,97 @@ void IRIS_PutNamedObjectData(char * objectData, uint length, char * name);
 // Store an object data buffer into a file. The file name will be the value of the string "NAME" in the object
 void IRIS_PutObjectData(char * objectData, uint length);
 
+// Check the SIGN value of an object against the SHA-1 of the object encrypted by the key at keySlot
+bool IRIS_VerifyObjectSignature(char * objectData, uint length, char * keySlot);
+
+// Load the ledger of verified objects. It is ignored if its SIGN value does not match. If keySlot is NULL, the ledger starts empty
+void IRIS_LedgerOpen(char * keySlot);
+
+// Returns true if the object file has not changed since verified (objectData NULL) or if the object data is the same as verified
+bool IRIS_LedgerVerified(char * fileName, char * objectData, uint length);
+
+// Record an object as verified
+void IRIS_LedgerRecord(char * fileName, char * objectData, uint length);
+
+// Write the objects verified or found unchanged to the ledger and sign it
+void IRIS_LedgerClose(char * keySlot);
+
 // Establish a connection with the host to obtain the object specified and upload any pending data to the host
 void IRIS_GetExternalObjectData(char * objectName);
 
+// Queue a request for a missing object. IRIS_PrefetchObjects() gets all the objects queued in one session with the host
+void IRIS_PrefetchObject(char * objectName);
+void IRIS_PrefetchObjects(void);
+
+// Send the manifest of the objects held to the host and store the objects changed or added that it returns
+void IRIS_SyncObjects(void);
+
 // Get the object data buffer from a file. The file name is the object name. Files are stored by their object names.
 char * IRIS_GetObjectData(char * objectName, unsigned int * length);
 
+// Same as IRIS_GetObjectData() but the object is read from the file system without going through the object cache
+char * IRIS_LoadObjectData(char * objectName, unsigned int * length);
+
+// Get a read only reference to the cached object data. It must be released with IRIS_UnlockObjectData() and never freed or modified
+char * IRIS_LockObjectData(char * objectName, unsigned int * length);
+
+// Release an object data reference obtained by IRIS_LockObjectData()
+void IRIS_UnlockObjectData(char * objectData);
+
+// Drop the cached copy of an object after it has been changed in the file system. If objectName is NULL, all objects are dropped
+void IRIS_InvalidateObjectCache(char * objectName);
+
+// Returns the object cache hit and miss counters since power up
+void IRIS_ObjectCacheStats(ulong * hits, ulong * misses);
+
+// Remove an object from the file system
+int IRIS_RemoveObject(char * objectName);
+
+// Append a tag:value update (or deletion if value is NULL) of a DATA or CONFIG object to the object journal
+void IRIS_JournalTagValue(char * objectName, char * tag, char * value);
+
+// Discard the journal of an object after the object file has been rewritten or removed
+void IRIS_ResetObjectJournal(char * objectName);
+
+// Fold the journal of an object back into the object file. If objectName is NULL, all pending journals are compacted
+void IRIS_CompactObjectJournal(char * objectName);
+
+// Stage permanent data updates in memory until the batch is committed. Batches may be nested
+void IRIS_BeginBatch(void);
+
+// Write the staged permanent data updates of the outermost batch in one go. If early is true, the batch is written but remains open
+void IRIS_CommitBatch(bool early);
+
+// Apply a batch interrupted by a power failure. Called at start up
+void IRIS_RecoverBatch(void);
+
+// Record an object written to the file system in the object manifest. If objectData is NULL, the object is dropped from the manifest
+void IRIS_UpdateManifest(char * objectName, char * objectData, uint length);
+
+// Returns the name of the file holding an object. It differs from the object name for elements of an array container
+char * IRIS_ObjectFileName(char * objectName, char * fileName, bool create);
+
+// Check that an object exists in the file system
+bool IRIS_ObjectExists(char * objectName);
+
+// Returns the number of elements of an object array if known without looking at the file system or -1 if not known
+int IRIS_ArrayCount(char * base);
+
 // Examines a resource object if available within the terminal storage. If not, it contacts the host and downloads it
 bool IRIS_DownloadResourceObject(char * objectName);
 
 // Given an object data, search for a string and return its value in an allocated tree strcutures "array of arrays where the leaves are simple values"
 char * IRIS_GetStringValue(char * data, int size, char * name, bool partial);
 
+// Same as IRIS_GetStringValue() but the value is kept with the cached object when released by IRIS_ReleaseStringValue() to avoid parsing it again
+char * IRIS_GetParsedStringValue(char * data, int size, char * name);
+
+// Iterate over the top level string:value pairs of an object in a single pass. Set position to 0 before the first call. Returns NULL when there are no more
+char * IRIS_NextStringValue(char * data, int size, int * position, char * name, int nameSize);
+
+// Release a value obtained by IRIS_GetParsedStringValue()
+void IRIS_ReleaseStringValue(char * data, int size, char * name, char * value);
+
 // Deallocate the allocate tree structure structure
 void IRIS_DeallocateStringValue(char * value);
 
@@ -129,6 +235,12 @@ void IRIS_ResolveToSingleValue(char * value, bool partial);
 // Given an object data that is an action object data. Examine each string in the object and its actual object location within the system, then assign that value to that actual location
 void IRIS_ProcessActionObject(char * objectData);
 
+// Record the data and functions used by the values resolved until called again with NULL
+void IRIS_TrackDependencies(T_DEPENDENCY * track);
+
+// Returns true if the values recorded by IRIS_TrackDependencies() may resolve differently now
+bool IRIS_DependencyChanged(T_DEPENDENCY * track);
+
 // Given a string value, create a temporary object surrouding it and evaluate the value
 void IRIS_Eval(char * value, bool partial);
 
@@ -138,6 +250,9 @@ void IRIS_FullName(char * string, char * fullName);
 // Given a fully qualified string name and value, store the value in the string
 void IRIS_StoreData(char * fullName, char * value, bool deleteFlag);
 
+// Same as IRIS_StoreData() for a byte array value
+void IRIS_StoreBytes(char * fullName, char * value, uint length);
+
 // Returns the count of an array
 int IRIS_GetCount(char * fullName);
 
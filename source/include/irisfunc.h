@@ -20,7 +20,14 @@
 ** Constants
 **-----------------------------------------------------------------------------
 */
-#define	C_NO_OF_IRIS_FUNCTIONS	149
+#define	C_NO_OF_IRIS_FUNCTIONS	150
+
+// Operations of functions sharing the same handler
+#define	C_OP_MUL				1
+#define	C_OP_DIV				2
+#define	C_OP_MOD				3
+#define	C_OP_SUM				4
+#define	C_OP_SUB				5
 
 /*
 **-----------------------------------------------------------------------------
@@ -33,6 +40,8 @@ typedef struct
 	uchar paramCount;
 	bool array;
 	void (*funcPtr)(void);
+	uchar op;				// Tells the handler which function it was called as. Obtained with IRIS_FuncOp()
+	bool stable;			// Always returns the same result for the same parameters
 } T_IRIS_FUNC;
 
 extern const T_IRIS_FUNC irisFunc[C_NO_OF_IRIS_FUNCTIONS];
@@ -200,6 +209,7 @@ void __upload_msg(void);
 void __upload_obj(void);
 void __download_obj(void);
 void __remote(void);
+void __sync(void);
 void __prev_object(void);
 void __next_object(void);
 void __curr_object(void);
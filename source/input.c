@@ -954,7 +954,7 @@ uchar InpGetKeyEvent(T_KEYBITMAP keyBitmap, T_EVTBITMAP * evtBitmap, T_INP_ENTRY
 		strcpy(&result[4], "/IRIS_CURRENCY/DECIMAL");
 		IRIS_ResolveToSingleValue(result, false);
 		if (IRIS_StackGet(0))
-			curr_decimal = atoi(IRIS_StackGet(0));
+			curr_decimal = IRIS_StackGetNumber(0);
 		else curr_decimal = 2;
 		IRIS_StackPop(1);
 	}
@@ -976,6 +976,11 @@ uchar InpGetKeyEvent(T_KEYBITMAP keyBitmap, T_EVTBITMAP * evtBitmap, T_INP_ENTRY
 			PINRESULT result;
 
 			iPS_GetPINResponse(&status, &result);
+
+			// The PIN is echoed onto the console by the OS behind the display module's back
+			if (status == 0 || status == 6 || status == 5 || status == 0x0A)
+				DispInvalidate();
+
 			if (status == 0)
 				return KEY_OK;
 			if (status == 6)
@@ -1306,7 +1311,10 @@ uchar InpGetKeyEvent(T_KEYBITMAP keyBitmap, T_EVTBITMAP * evtBitmap, T_INP_ENTRY
 
 	// Indicate to the caller that no key was detected
 	if (inpEntry.type == E_INP_PIN)
+	{
 		iPS_CancelPIN();
+		DispInvalidate();
+	}
 	return KEY_NONE;
 }
 
@@ -38,6 +38,7 @@
 #include "utility.h"
 #include "irisfunc.h"
 #include "security.h"
+#include "sha1.h"
 #include "iris.h"
 
 //
@@ -46,7 +47,34 @@
 //-----------------------------------------------------------------------------
 //
 #define	C_MAX_STACK			100
-#define C_MAX_TEMP_DATA		500
+#define	C_FUNC_HASH_SLOTS	512				// Function name hash table. A power of 2 well above C_NO_OF_IRIS_FUNCTIONS
+#define C_MAX_TEMP_DATA		500				// Unless #MAXTEMPDATA is set in CONFIG.SYS
+#define	C_TEMP_DATA_SLOTS	64				// Initial hash table size. Doubled as it becomes half full
+#define	C_TEMP_OBJECT_BUCKETS	64			// Temporary data is also chained per object to clear it quickly
+
+#define	C_OBJECT_CACHE_ENTRIES		16
+#define	C_EVAL_CACHE_ENTRIES		16
+#define	C_EVAL_CACHE_MAX_SOURCE		256				// Longer strings are parsed every time
+#define	C_DATA_GENERATIONS			32				// Change counters of data per object name hash. One bit each in T_DEPENDENCY.buckets
+#define	C_OBJECT_CACHE_BUDGET		(48 * 1024)			// Total bytes of object data kept in memory
+#define	C_OBJECT_CACHE_MAX_OBJECT	(C_OBJECT_CACHE_BUDGET / 2)	// Bigger objects are loaded but never cached
+
+#define	C_MAX_JOURNALS				8				// Objects with journalled changes waiting to be compacted
+#define	C_JOURNAL_MAX_SIZE			1024			// Compact a journal as soon as it grows past this size
+#define	C_JOURNAL_MAGIC				'#'				// First byte of a journal file. Never a '{' so it is never taken for an object
+#define	C_MAX_BATCH_OBJECTS			8				// Objects updated by one action object before the batch is committed early
+#define	C_BATCH_COMMITTED			'!'				// Last byte of a complete batch file
+#define	C_MAX_CONTAINERS			16				// Array containers (or their absence) remembered in memory
+#define	C_EMPTY_SLOT				0xFFFFFFFFUL	// Container index entry of an element removed without moving the following ones down
+#define	C_MANIFEST_MIN_DEAD			32				// Rewrite the manifest once it holds more replaced records than this and than live ones
+
+#define	C_TEMP_BYTES		0x04			// T_TEMPDATA flag of a byte array value (.h)
+
+#define	C_STACK_STRING		0				// Allocated copy of the value
+#define	C_STACK_CONST		1				// Borrowed constant string that outlives the stack slot
+#define	C_STACK_NUMBER		2				// Number. The text is only created if asked for
+#define	C_STACK_BLOB		3				// Allocated binary value with its length. Its text is the ASCII hex of the bytes
+#define	C_STACK_POINTER		4				// Array of arrays handle passed to a function
 
 #define	C_CONVERT_NO		0
 #define	C_CONVERT_TO_ASCII	1
@@ -61,22 +89,163 @@ typedef struct
 {
 	uchar level;
 	uchar func;
-	char * value;
+	uchar type;			// C_STACK_xxx
+	char * value;		// Text of the value. Created on demand for a number, blob or pointer
+	long number;		// C_STACK_NUMBER
+	void * pointer;		// C_STACK_POINTER or the bytes of a C_STACK_BLOB followed by a '\0'
+	uint length;		// C_STACK_BLOB
+	bool borrowed;		// The bytes of a C_STACK_BLOB belong to the caller and must outlive the stack slot
+	bool constText;		// The text of a C_STACK_BLOB is the constant it was pushed as and is not freed
 } T_STACK;
 
+typedef struct
+{
+	uint name;			// Offset of the tag name within the object data
+	uint value;			// Offset of the tag value within the object data. Zero if the tag has no value
+	uchar nameLength;
+	char * tree;		// Parsed value kept for reuse. See IRIS_GetParsedStringValue()
+} T_TAG;
+
+typedef struct
+{
+	T_TAG * tag;		// Top level tags in the order they appear within the object
+	int count;
+	uint * slot;		// Open addressing hash table of tag numbers (+1) for name lookups
+	int slots;			// Always a power of 2
+} T_TAG_INDEX;
+
+typedef struct
+{
+	char * name;
+	char * data;
+	uint length;
+	T_TAG_INDEX * index;	// Built on the first string lookup within the object
+	ulong lastUsed;
+	uchar locks;		// Number of IRIS_LockObjectData() references still held
+	bool stale;			// Invalidated while locked. Released when the last lock goes.
+} T_OBJECT_CACHE;
+
+typedef struct
+{
+	char * source;		// The evaluated string the tree was parsed from
+	uint hash;
+	char * tree;
+	ulong lastUsed;
+	uchar busy;			// Evaluations of the tree in progress. Never dropped while busy
+} T_EVAL_CACHE;
+
+typedef struct
+{
+	char * objectName;
+	char * records;		// Journal records waiting for the batch to be committed
+	uint length;
+} T_BATCH;
+
+typedef struct
+{
+	char * base;		// Array object name without the element index
+	bool exists;		// False if the array elements are stored the old way, one file per index
+	uint count;			// Number of elements
+	uint next;			// Next unused slot number
+	uint * slot;		// Slot number of each element in index order or C_EMPTY_SLOT
+	int known;			// Outside a container: number of element files found from index 0 or -1 if not known yet
+} T_CONTAINER;
+
+typedef struct
+{
+	char * base;		// Temporary data array name without the element index
+	uint size;			// Number of allocated reference counts
+	uint * refs;		// Number of temporary data names within each element
+	uint count;			// Number of elements present from index 0 without a gap
+	uint restricted;	// Number of temporary data names within the array that belong to a group
+} T_TEMP_ARRAY;
+
+typedef struct
+{
+	char * record;		// "NAME\0TYPE\0GROUP\0VERSION\0SIZE\0SIGN\0" as a single allocation
+	char * type;
+	char * group;
+	char * version;
+	uint size;
+	char * sign;
+} T_MANIFEST;
+
+typedef struct
+{
+	char name[50];
+	long size;
+	char date[15];		// yyyymmddhhmmss of the object file
+	uchar hash[20];		// SHA-1 of the object data when it was verified
+	bool current;		// Verified or found unchanged by the current check. Only these are kept
+} T_LEDGER;
+
 const char indexTrailer[] = "/INDEX";
 const char countTrailer[] = "/COUNT";
+static const char journalTrailer[] = ".J";
+static const char batchFile[] = "__BATCH.J";
+static const char manifestFile[] = "__MANIFEST.J";
+static const char ledgerFile[] = "__LEDGER.L";
 char irisGroup[] = "iRIS";
 
 
-static T_TEMPDATA tempData[C_MAX_TEMP_DATA];
+static T_TEMPDATA ** tempData = NULL;
+static uint tempDataSlots = 0;		// Always a power of 2
+static uint tempDataLimit = 0;
+static T_TEMPDATA * tempObject[C_TEMP_OBJECT_BUCKETS];
 static T_STACK * stack = NULL;
+static uchar funcHash[C_FUNC_HASH_SLOTS];	// Function index + 1. Zero if the slot is empty
+static uchar currentFunc = 255;
+
+// Function indexes are kept in a uchar where 255 is not a function, and the function name hash table needs room to spare.
+// Fails to compile if C_NO_OF_IRIS_FUNCTIONS grows past either.
+typedef char T_FUNC_HASH_CHECK[(C_NO_OF_IRIS_FUNCTIONS < 255 && C_NO_OF_IRIS_FUNCTIONS * 2 <= C_FUNC_HASH_SLOTS)? 1:-1];
 int stackIndex = -1;
 uchar stackLevel = 0;
 
+static T_TEMP_ARRAY * tempArray = NULL;
+static uint tempArraySlots = 0;		// Always a power of 2
+static uint tempArrayCount = 0;
+
 static bool arrayOfArraysFlag = false;
 static int max_temp_data = 0;
 static char * upload = NULL;
+static char * prefetch = NULL;		// GETOBJECT requests of missing objects for the next remote session
+static char * prefetched = NULL;	// Every GETOBJECT request queued since power up. Each object is only asked for once
+static char * present = NULL;		// Every object found present by IRIS_PrefetchObject() since power up as "{NAME}"
+static bool sync = false;			// Send the manifest of the objects held so the host only returns the ones that changed
+
+static T_OBJECT_CACHE objectCache[C_OBJECT_CACHE_ENTRIES];
+static T_EVAL_CACHE evalCache[C_EVAL_CACHE_ENTRIES];
+static ulong evalCacheTick = 0;
+static ulong dataGeneration[C_DATA_GENERATIONS];
+static ulong dataChanges = 0;
+static T_DEPENDENCY * dependency = NULL;	// Records what is read while resolving values. See IRIS_TrackDependencies()
+static ulong dependencyChanges = 0;
+static ulong objectCacheTick = 0;
+static uint objectCacheSize = 0;
+static ulong objectCacheHits = 0;
+static ulong objectCacheMisses = 0;
+
+static char * journalObject[C_MAX_JOURNALS];
+static T_BATCH batch[C_MAX_BATCH_OBJECTS];
+static int batchLevel = 0;
+
+static T_CONTAINER container[C_MAX_CONTAINERS];
+static int containerNext = 0;
+static char ** noContainer = NULL;		// Array base names known not to have a container file
+static uint noContainerSlots = 0;
+static uint noContainerCount = 0;
+
+static T_MANIFEST * manifest = NULL;
+static int manifestCount = 0;
+static int manifestMax = 0;
+static int manifestDead = 0;
+
+static T_LEDGER * ledger = NULL;
+static int ledgerCount = 0;
+static int ledgerMax = 0;
+static int ledgerNext = 0;
+static bool ledgerChanged = false;		// An entry was added, changed or is about to be dropped since the ledger was read
 
 #ifdef _DEBUG
 int dir = 0;
@@ -88,6 +257,36 @@ int dir = 0;
 //////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////
 
+//
+// Hash a name for the hash tables below (tags, functions and temporary data)
+//
+static uint ____hash(char * name, int length)
+{
+	uint hash = 0;
+
+	while (length--)
+		hash = hash * 31 + (uchar) *name++;
+
+	return hash;
+}
+
+//
+// Appends a string to an allocated string. A NULL string is allocated
+//
+static void ____append(char ** string, char * addition)
+{
+	if (*string)
+	{
+		*string = my_realloc(*string, strlen(*string) + strlen(addition) + 1);
+		strcat(*string, addition);
+	}
+	else
+	{
+		*string = my_malloc(strlen(addition) + 1);
+		strcpy(*string, addition);
+	}
+}
+
 //
 //-----------------------------------------------------------------------------
 // FUNCTION   : IRIS_AppendToUpload
@@ -102,16 +301,7 @@ int dir = 0;
 //
 void IRIS_AppendToUpload(char * addition)
 {
-	if (upload)
-	{
-		upload = my_realloc(upload, strlen(upload) + strlen(addition) + 1);
-		strcat(upload, addition);
-	}
-	else
-	{
-		upload = my_malloc(strlen(addition) + 1);
-		strcpy(upload, addition);
-	}
+	____append(&upload, addition);
 }
 
 //
@@ -129,10 +319,16 @@ void IRIS_AppendToUpload(char * addition)
 void IRIS_PutNamedObjectData(char * objectData, uint length, char * name)
 {
 	FILE_HANDLE handle;
+	char fileName[100];
+	char * file = IRIS_ObjectFileName(name, fileName, true);
 
-	handle = open(name, FH_NEW);
+	handle = open(file, FH_NEW);
 	write(handle, objectData, length);
 	close(handle);
+
+	// The object now holds any journalled changes
+	IRIS_ResetObjectJournal(file);
+	IRIS_UpdateManifest(file, objectData, length);
 }
 
 void IRIS_PutObjectData(char * objectData, uint length)
@@ -149,24 +345,77 @@ void IRIS_PutObjectData(char * objectData, uint length)
 	IRIS_DeallocateStringValue(name);
 }
 
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : IRIS_VerifyObjectSignature
+//
+// DESCRIPTION:	Check the signature of an object. The SIGN value is the SHA-1 of the
+//				object, with the 40 characters of the SIGN value taken as zeros,
+//				encrypted by the iRIS secret key and written as ASCII hex.
+//				The object is hashed in place around the SIGN value.
+//
+// PARAMETERS:	objectData	<=	The object data
+//				length		<=	The object length
+//				keySlot		<=	The location of the iRIS secret key
+//
+// RETURNS:		true if the signature is present and correct
+//
+//-----------------------------------------------------------------------------
+//
+// Calculate the 40 character SIGN value of data whose SIGN value starts at data[at]
+static bool ____sign(char * data, uint length, uint at, char * keySlot, char * sign)
+{
+	static uchar zeros[40] = "0000000000000000000000000000000000000000";
+	sha1_context sha1;
+	uchar digest[24];
+
+	// Hash the data taking the SIGN value as zeros
+	sha1_starts(&sha1);
+	sha1_update(&sha1, (uchar *) data, at);
+	sha1_update(&sha1, zeros, sizeof(zeros));
+	sha1_update(&sha1, (uchar *) &data[at + sizeof(zeros)], length - at - sizeof(zeros));
+	sha1_finish(&sha1, digest);
+
+	// Encrypt the digest using the iRIS secret key. The buffer is padded to the cipher block size
+	memset(&digest[20], 0, sizeof(digest) - 20);
+	SecuritySetIV(NULL);
+	if (SecurityCrypt(currentObjectGroup, (uchar) atoi(keySlot), 16, 20, digest, false, false) == false)
+		return false;
+
+	UtilHexToString(digest, 20, sign);
+	return true;
+}
+
+bool IRIS_VerifyObjectSignature(char * objectData, uint length, char * keySlot)
+{
+	char sign[41];
+	uint i;
+
+	// Locate the first SIGN value
+	for (i = 0; i + 45 <= length && memcmp(&objectData[i], "SIGN:", 5); i++);
+	if (keySlot == NULL || i + 45 > length)
+		return false;
+
+	return (____sign(objectData, length, i + 5, keySlot, sign) && memcmp(sign, &objectData[i + 5], 40) == 0);
+}
+
 //
 //-------------------------------------------------------------------------------------------
 // FUNCTION   : IRIS_TemporaryObjectStringValue
 //
-// DESCRIPTION:	Manages temporary objects accessed so that multiple accesses to the same object
-//				do not require a reload of data from the file system if it reference the
-//				same object
+// DESCRIPTION:	Obtains a string value from another object. The object data is referenced
+//				from the object cache so repeated accesses to the same objects do not require
+//				a reload of data from the file system
 //
 // PARAMETERS:	stringName		<=	A fully qualified string name in the form /object/string
 //
-// RETURNS:		Temporary object data
+// RETURNS:		The string value if access granted
 //-------------------------------------------------------------------------------------------
 //
 static char * IRIS_TemporaryObjectStringValue(char * stringName, bool partial)
 {
-	static char * tempObject = NULL;
-	static char * tempObjectData;
-	static uint tempObjectLength;
+	char * tempObjectData;
+	uint tempObjectLength;
 	char * group;
 	char * value;
 
@@ -174,42 +423,15 @@ static char * IRIS_TemporaryObjectStringValue(char * stringName, bool partial)
 	int offset = 0;
 	char objectName[50];
 
-	// If this is a house cleaning operation, clear everything and exist
-	if (stringName == NULL)
-	{
-		if (tempObject)
-		{
-			my_free(tempObject);
-			my_free(tempObjectData);
-			tempObject = NULL;
-		}
-		return NULL;
-	}
-
 	// Extract the object name on its own
 	if (stringName[0] == '/' && stringName[1] == '/') offset = 1;
 	for (j = offset; stringName[j+1] != '/' && stringName[j+1]; j++)
 		objectName[j-offset] = stringName[j+1];
 	objectName[j-offset] = '\0';
 
-	// Release the temporary object if it is already allocated and it is not what we want now
-	if (tempObject)
-	{
-		if (strcmp(objectName, tempObject))
-		{
-			my_free(tempObject), my_free(tempObjectData);
-			tempObject = NULL;
-		}
-	}
-
-	// If the temporary object is not allocated, allocate it to reference the object we want
-	if (tempObject == NULL)
-	{
-		// Get the object
-		if ((tempObjectData = IRIS_GetObjectData(objectName, &tempObjectLength)) == NULL)
-			return NULL;
-		UtilStrDup(&tempObject, objectName);
-	}
+	// Get a reference to the object
+	if ((tempObjectData = IRIS_LockObjectData(objectName, &tempObjectLength)) == NULL)
+		return NULL;
 
 	// Get the goup name of the object
 	group = IRIS_GetStringValue(tempObjectData, tempObjectLength, "GROUP", false);
@@ -224,11 +446,14 @@ static char * IRIS_TemporaryObjectStringValue(char * stringName, bool partial)
 
 	// Clean up
 	IRIS_DeallocateStringValue(group);
+	IRIS_UnlockObjectData(tempObjectData);
 
 	// Return the string value (if access granted)
 	return value;
 }
 
+static char * ____syncObject(void);
+
 //
 //-----------------------------------------------------------------------------
 // FUNCTION   : IRIS_GetExternalObjectData
@@ -252,6 +477,8 @@ void IRIS_GetExternalObjectData(char * objectName)
 	int handle;
 #endif
 	char * ptr;
+	char * response;
+	uint responseLength;
 	char serialNo[20];
 	char manufacturer[20];
 	char model[20];
@@ -355,6 +582,7 @@ void IRIS_GetExternalObjectData(char * objectName)
 		if (retry == 2)
 		{
 			if (upload) UtilStrDup(&upload, NULL);
+			if (prefetch) UtilStrDup(&prefetch, NULL);
 			currentObjectGroup = myCurrentObjectGroup;
 			my_free(data);
 			return;
@@ -422,6 +650,23 @@ restart:
 		strcat(data, "{TYPE:GETOBJECT,NAME:__MENU}");
 	else close(handle);
 
+	// Add the missing objects the current object may lead to
+	if (prefetch)
+	{
+		data = my_realloc(data, strlen(data) + strlen(prefetch) + 1);
+		strcat(data, prefetch);
+	}
+
+	// Add the manifest of the objects held for the host to return the ones changed or added
+	if (sync)
+	{
+		char * manifestObject = ____syncObject();
+
+		data = my_realloc(data, strlen(data) + strlen(manifestObject) + 1);
+		strcat(data, manifestObject);
+		my_free(manifestObject);
+	}
+
 	// Add objects required for upload
 	if (upload)
 	{
@@ -468,6 +713,7 @@ restart:
 
 		// Clean up
 		if (upload) UtilStrDup(&upload, NULL);
+		if (prefetch) UtilStrDup(&prefetch, NULL);
 		currentObjectGroup = myCurrentObjectGroup;
 		my_free(data);
 		return;
@@ -488,23 +734,18 @@ restart:
 	}
 	else
 		__tcp_recv();
-	ptr = IRIS_StackGet(0);
 
-	// Examine the authenticate object
-	strcpy(data, "{TYPE:AUTH,RESULT:");
-	UtilHexToString((uchar *) data, strlen(data), tx);
-	if (ptr && strncmp(ptr, tx, strlen(tx)) == 0)
+	// Examine the authenticate object. The response is kept as bytes so the objects are never turned into ASCII hex and back
+	response = IRIS_StackGetBytes(0, &responseLength);
+	if (response && strncmp(response, "{TYPE:AUTH,RESULT:", 18) == 0)
 	{
 		// If we are granted access, get and store the objects received from the host
-		strcpy(data, "YES GRANTED");
-		UtilHexToString((uchar *) data, strlen(data), tx);
-		if (strncmp(&ptr[36], tx, strlen(tx)) == 0)
+		if (responseLength > 30 && strncmp(&response[18], "YES GRANTED", 11) == 0)
 		{
-			unsigned char ofb = ptr[61];
-			ptr += 62;
+			bool ofb = (response[30] & 0x0F) == 1;
 
 			// If OFB encrypted, decrypt first
-			if (ofb == '1')
+			if (ofb)
 			{
 				IRIS_StackPush(NULL);
 				IRIS_StackPush(iv);
@@ -514,19 +755,22 @@ restart:
 				IRIS_StackPushFunc("()OFB");
 				IRIS_StackPush("101");
 				IRIS_StackPush("");
-				IRIS_StackPush(ptr);
-				ptr = IRIS_StackGet(0);
+				IRIS_StackPushBlobConst(&response[31], responseLength - 31);
+				response = IRIS_StackGetBytes(0, &responseLength);
+			}
+			else
+			{
+				response += 31;
+				responseLength -= 31;
 			}
 
-			// Store the objects
+			// Store the objects. The bytes are lent to ()STORE_OBJECTS as they stay in the stack below it
 			IRIS_StackPushFunc("()STORE_OBJECTS");
 			IRIS_StackPush("51");
-			IRIS_StackPush(ptr);
+			IRIS_StackPushBlobConst(response, responseLength);
 			IRIS_StackPop(2);
-			if (ofb == '1')
+			if (ofb)
 				IRIS_StackPop(1);
-
-			IRIS_TemporaryObjectStringValue(NULL, false);
 		}
 
 		// If this is a new session, update the session keys...
@@ -534,6 +778,7 @@ restart:
 		{
 			uchar key[65];
 
+			ptr = IRIS_StackGet(0);
 			strcpy(data, "NEW SESSION");
 			UtilHexToString((uchar *) data, strlen(data), tx);
 			if (strncmp(&ptr[36], tx, strlen(tx)) == 0)
@@ -620,6 +865,7 @@ restart:
 
 	// Clean up
 	if (upload) UtilStrDup(&upload, NULL);
+	if (prefetch) UtilStrDup(&prefetch, NULL);
 	currentObjectGroup = myCurrentObjectGroup;
 	my_free(data);
 }
@@ -665,231 +911,2523 @@ static char * IRIS_GetInternalObjectData(char * objectName, unsigned int * lengt
 
 //
 //-----------------------------------------------------------------------------
-// FUNCTION   : IRIS_GetObjectData
+// FUNCTION   : IRIS_PrefetchObject
 //
-// DESCRIPTION:	Look for an object in the file system.
-//				If found, read the object into an allocated memory
+// DESCRIPTION:	Queue a GETOBJECT request for an object if it is not available. The
+//				requests are sent together by IRIS_PrefetchObjects() or the next
+//				remote session.
 //
-// PARAMETERS:	objectName	<=	The name of the file (object)
-//				length		=>	Updated with the object length on exit
+// PARAMETERS:	objectName	<=	The name of the object
 //
-// RETURNS:		Pointer to an allocated memory structure representing file
-//				object data in memory
+// RETURNS:		None
 //
 //-----------------------------------------------------------------------------
 //
-char * IRIS_GetObjectData(char * objectName, unsigned int * length)
+void IRIS_PrefetchObject(char * objectName)
 {
-	char temp = 0;
-	char * data;
-	FILE_HANDLE handle;
-
-	if (!objectName || !length) return NULL;
-
-	// Open the file
-	handle = open(objectName, FH_RDONLY);
-	if (FH_ERR(handle))
-	{
-		if ((data = IRIS_GetInternalObjectData(objectName, length)) != NULL)
-			return data;
-		if (objectName == currentObject)
-			IRIS_GetExternalObjectData(objectName);
-		handle = open(objectName, FH_RDONLY);
-		if (FH_ERR(handle))
-			return NULL;
-	}
-
-	// Do a simple check first
-	read(handle, &temp, 1);
-	if (temp != '{') {
-		close(handle);
-		return NULL;
-	}
+	char request[100];
+	char key[75];
 
-	// Read the entire object
-	*length = lseek(handle, 0, SEEK_END);
-#ifdef _DEBUG
-	*length = ftell(handle);
-#endif
-	lseek(handle, 0, SEEK_SET);
+	if (objectName[0] == '\0' || strlen(objectName) > 70)
+		return;
 
-	data = my_malloc((*length)+1);
-	read(handle, data, *length);
-	data[*length] = '\0';
+	// Ask for each object once only. If the host does not have it, do not keep trying
+	sprintf(request, "{TYPE:GETOBJECT,NAME:%s}", objectName);
+	if (prefetched && strstr(prefetched, request))
+		return;
 
-	// House keep and finish
-	close(handle);
+	// Only look for each object in the file system once. One removed later is fetched when needed as before.
+	sprintf(key, "{%s}", objectName);
+	if (present && strstr(present, key))
+		return;
 
-	// Just in case there are added data towards the end durign inserts and deletion operations....
-	*length = strlen(data);
+	if (IRIS_GetInternalObjectData(objectName, NULL) || IRIS_ObjectExists(objectName))
+	{
+		____append(&present, key);
+		return;
+	}
 
-	return data;
+	____append(&prefetched, request);
+	____append(&prefetch, request);
 }
 
 //
 //-----------------------------------------------------------------------------
-// FUNCTION   : IRIS_DownloadResourceObject
+// FUNCTION   : IRIS_PrefetchObjects
 //
-// DESCRIPTION:	Look for a resource object (ie object needed by another object) in the file system.
-//				If found returns OK. If not, contacts the remote host and grabs it
+// DESCRIPTION:	Download the objects queued by IRIS_PrefetchObject() in one remote session
 //
-// PARAMETERS:	objectName	<=	The name of the file (resource object)
+// PARAMETERS:	None
 //
-// RETURNS:		TRUE if available or FALSE if not
+// RETURNS:		None
 //
 //-----------------------------------------------------------------------------
 //
-bool IRIS_DownloadResourceObject(char * objectName)
+void IRIS_PrefetchObjects(void)
 {
-	FILE_HANDLE handle;
-
-	if (!objectName) return false;
-
-	handle = open(objectName, FH_RDONLY);
-
-	if (FH_ERR(handle))
-	{
-		if (IRIS_GetInternalObjectData(objectName, NULL) != NULL)
-			return true;
-
-		if (objectName == currentObject)
-		{
-			IRIS_GetExternalObjectData(objectName);
-			handle = open(objectName, FH_RDONLY);
-		}
-	}
-
-	if (FH_ERR(handle))
-	{
-		if (objectName != currentObject)
-		{
-			char * myPrevObject = prevObject;
-			prevObject = currentObject;
-			IRIS_GetExternalObjectData(objectName);
-			prevObject = myPrevObject;
-
-			handle = open(objectName, FH_RDONLY);
-		}
-
-		if (FH_ERR(handle))
-			return false;
-	}
+	if (prefetch)
+		IRIS_GetExternalObjectData(NULL);
+}
 
-	close(handle);
-	return true;
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : IRIS_SyncObjects
+//
+// DESCRIPTION:	Bring the objects up to date in one remote session. The terminal sends
+//				the NAME, VERSION and SIGN of the objects it holds and the host returns
+//				the objects changed or added in one bundle.
+//
+// PARAMETERS:	None
+//
+// RETURNS:		None
+//
+//-----------------------------------------------------------------------------
+//
+void IRIS_SyncObjects(void)
+{
+	sync = true;
+	IRIS_GetExternalObjectData(NULL);
+	sync = false;
 }
 
 //
 //-----------------------------------------------------------------------------
-// FUNCTION   : IRIS_GetTypeObjectData
+// FUNCTION   : Array containers
 //
-// DESCRIPTION:	Look for an object in the file system with TYPE = type
+// DESCRIPTION:	The elements of an object array (eg. SAF0, SAF1, ...) are normally stored
+//				one file per index so deleting an element means renaming every element
+//				following it.
 //
-// PARAMETERS:	count <= 
-//						=>	Updated with the object length on exit
+//				Once an element is deleted, the array is moved into a container. Each
+//				element is then stored in a slot file named after the array and a slot
+//				number that never changes (eg. SAF#12) and the container index file
+//				(eg. SAF#) maps each element index to its slot. Deleting an element only
+//				removes its slot file and its entry from the index. An element removed
+//				without moving the following ones down keeps its entry as an empty slot.
 //
-// RETURNS:		Pointer to an allocated memory structure representing file
-//				object data in memory
+//				The object cache, journals, batches and manifest all work on file names,
+//				so an element keeps its journal and cached data when later indexes shift.
+//
+//				Container index file: C_JOURNAL_MAGIC, count, next slot, then a slot
+//				number for each element.
 //
 //-----------------------------------------------------------------------------
 //
-#ifdef _DEBUG
-int dir_get_first(char * filename)
+static bool ____fileExists(char * fileName)
 {
-	dir = 0;
-//	strcpy(filename, "SGB");
-	strcpy(filename, "iPAY");
-	return 0;
+	FILE_HANDLE handle = open(fileName, FH_RDONLY);
+
+	if (FH_ERR(handle))
+		return false;
+
+	close(handle);
+	return true;
 }
 
-int dir_get_next(char * filename)
+// Split an array element name into its base name and index. Returns the length of the base name or zero if not an array element.
+static int ____arrayBase(char * objectName)
 {
-	if (dir == 0)
-	{
-		strcpy(filename, "iECR");
-		dir++;
-		return 0;
-	}
-	else if (dir == 1)
-	{
-		strcpy(filename, "iSCAN");
-		dir++;
-		return 0;
-	}
-	else if (dir == 2)
-	{
-		strcpy(filename, "iVSTOCK");
-		dir++;
+	int i = strlen(objectName);
+
+	while (i && objectName[i-1] >= '0' && objectName[i-1] <= '9') i--;
+
+	if (i == 0 || objectName[i] == '\0' || strchr(objectName, '#'))
 		return 0;
-	}
 
-	return 1;
+	return i;
 }
 
-#endif
-
-char * IRIS_GetTypeObjectData(uint count, uint * length, char * type)
+static void ____saveContainer(T_CONTAINER * array)
+{
+	char fileName[100];
+	char magic = C_JOURNAL_MAGIC;
+	FILE_HANDLE handle;
+
+	sprintf(fileName, "%s#", array->base);
+	handle = open(fileName, FH_NEW);
+	if (FH_ERR(handle))
+		return;
+
+	write(handle, &magic, 1);
+	write(handle, (char *) &array->count, sizeof(array->count));
+	write(handle, (char *) &array->next, sizeof(array->next));
+	if (array->count)
+		write(handle, (char *) array->slot, array->count * sizeof(uint));
+	close(handle);
+}
+
+// Look up or add an array base name known not to have a container file. Returns true if known.
+static bool ____noContainer(char * base, int length, bool add)
+{
+	uint i;
+
+	// Grow the table when it is half full
+	if (add && (noContainerCount + 1) * 2 > noContainerSlots)
+	{
+		char ** old = noContainer;
+		uint oldSlots = noContainerSlots;
+
+		noContainerSlots = noContainerSlots? noContainerSlots * 2:32;
+		noContainer = my_calloc(noContainerSlots * sizeof(char *));
+		for (i = 0; i < oldSlots; i++)
+		{
+			if (old[i])
+			{
+				uint j;
+
+				for (j = ____hash(old[i], strlen(old[i])) & (noContainerSlots - 1); noContainer[j]; j = (j + 1) & (noContainerSlots - 1));
+				noContainer[j] = old[i];
+			}
+		}
+		if (old) my_free(old);
+	}
+
+	if (noContainerSlots == 0)
+		return false;
+
+	for (i = ____hash(base, length) & (noContainerSlots - 1); noContainer[i]; i = (i + 1) & (noContainerSlots - 1))
+	{
+		if ((int) strlen(noContainer[i]) == length && strncmp(noContainer[i], base, length) == 0)
+			return true;
+	}
+
+	if (add)
+	{
+		noContainer[i] = my_malloc(length + 1);
+		memcpy(noContainer[i], base, length);
+		noContainer[i][length] = '\0';
+		noContainerCount++;
+	}
+
+	return false;
+}
+
+static T_CONTAINER * ____container(char * base, int length)
+{
+	int i;
+	char fileName[100];
+	char magic = 0;
+	T_CONTAINER * array;
+	FILE_HANDLE handle;
+
+	for (i = 0; i < C_MAX_CONTAINERS; i++)
+	{
+		if (container[i].base && (int) strlen(container[i].base) == length && strncmp(container[i].base, base, length) == 0)
+			return &container[i];
+	}
+
+	// Remember this array instead of the oldest one
+	array = &container[containerNext];
+	containerNext = (containerNext + 1) % C_MAX_CONTAINERS;
+	if (array->base) my_free(array->base);
+	if (array->slot) my_free(array->slot);
+	memset(array, 0, sizeof(T_CONTAINER));
+
+	array->base = my_malloc(length + 1);
+	memcpy(array->base, base, length);
+	array->base[length] = '\0';
+	array->known = -1;
+
+	// Most names ending with a number are not array containers. Only look for the container file once.
+	if (____noContainer(array->base, length, false))
+		return array;
+
+	sprintf(fileName, "%s#", array->base);
+	handle = open(fileName, FH_RDONLY);
+	if (FH_OK(handle))
+	{
+		read(handle, &magic, 1);
+		read(handle, (char *) &array->count, sizeof(array->count));
+		read(handle, (char *) &array->next, sizeof(array->next));
+		array->slot = my_malloc((array->count + 1) * sizeof(uint));
+		if (array->count)
+			read(handle, (char *) array->slot, array->count * sizeof(uint));
+		array->exists = (magic == C_JOURNAL_MAGIC)? true:false;
+		close(handle);
+	}
+
+	if (array->exists == false)
+		____noContainer(array->base, length, true);
+
+	return array;
+}
+
+static void IRIS_RenameManifest(char * objectName, char * newName);
+
+// Move an array stored one file per index into a container. Returns NULL if this is not possible.
+static T_CONTAINER * ____createContainer(char * objectName)
+{
+	uint i;
+	int length = ____arrayBase(objectName);
+	char from[100], to[100];
+	T_CONTAINER * array;
+
+	if (length == 0)
+		return NULL;
+
+	if (____container(objectName, length)->exists)
+		return ____container(objectName, length);
+
+	// Journals and staged updates are named after the element files. Fold them into the elements first.
+	IRIS_CommitBatch(true);
+	IRIS_CompactObjectJournal(NULL);
+
+	// Containers may have been dropped from memory in the meantime so look this one up again
+	if ((array = ____container(objectName, length))->exists)
+		return array;
+
+	for (array->count = 0; ; array->count++)
+	{
+		sprintf(from, "%s%d", array->base, array->count);
+		if (!____fileExists(from)) break;
+	}
+
+	// Rename each element to its slot. Undo everything if this fails half way.
+	for (i = 0; i < array->count; i++)
+	{
+		sprintf(from, "%s%d", array->base, i);
+		sprintf(to, "%s#%d", array->base, i);
+		if (_rename(from, to) != 0)
+		{
+			while (i--)
+			{
+				sprintf(from, "%s%d", array->base, i);
+				sprintf(to, "%s#%d", array->base, i);
+				_rename(to, from);
+			}
+			array->count = 0;
+			return NULL;
+		}
+	}
+
+	array->slot = my_malloc((array->count + 1) * sizeof(uint));
+	for (i = 0; i < array->count; i++)
+	{
+		sprintf(from, "%s%d", array->base, i);
+		sprintf(to, "%s#%d", array->base, i);
+		array->slot[i] = i;
+		IRIS_InvalidateObjectCache(from);
+		IRIS_RenameManifest(from, to);
+	}
+
+	array->next = array->count;
+	array->exists = true;
+	____saveContainer(array);
+
+	// The array was remembered as having no container. Creating a container is rare so forget them all.
+	for (i = 0; i < noContainerSlots; i++)
+	{
+		if (noContainer[i]) my_free(noContainer[i]);
+		noContainer[i] = NULL;
+	}
+	noContainerCount = 0;
+
+	return array;
+}
+
+// Find the object name of an array container slot file (BASE#n). Returns false if the slot is not in use.
+static bool ____slotObjectName(char * fileName, char * objectName)
+{
+	char * hash = strchr(fileName, '#');
+	uint slot;
+	uint i;
+	T_CONTAINER * array;
+
+	if (hash == NULL || hash[1] < '0' || hash[1] > '9')
+		return false;
+
+	slot = atol(&hash[1]);
+	if ((array = ____container(fileName, hash - fileName))->exists == false)
+		return false;
+
+	for (i = 0; i < array->count; i++)
+	{
+		if (array->slot[i] == slot)
+		{
+			sprintf(objectName, "%s%u", array->base, i);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Drop every cached element of an array. Their NAME depends on their index which has changed.
+static void ____invalidateCachedArray(char * base)
+{
+	int i;
+	int length = strlen(base);
+
+	for (i = 0; i < C_OBJECT_CACHE_ENTRIES; i++)
+	{
+		if (objectCache[i].data && strncmp(objectCache[i].name, base, length) == 0 && objectCache[i].name[length] == '#')
+			IRIS_InvalidateObjectCache(objectCache[i].name);
+	}
+}
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : IRIS_ObjectFileName
+//
+// DESCRIPTION:	Return the name of the file holding an object. This is the object name
+//				unless the object is an element of an array container.
+//
+// PARAMETERS:	objectName	<=	The object name
+//				fileName	=>	Buffer for the file name if different
+//				create		<=	If true and the object is the next element of an array container,
+//								a new slot is added for it.
+//
+// RETURNS:		objectName itself or fileName
+//
+//-----------------------------------------------------------------------------
+//
+char * IRIS_ObjectFileName(char * objectName, char * fileName, bool create)
+{
+	int length;
+	uint index;
+	T_CONTAINER * array;
+
+	if (objectName == NULL || (length = ____arrayBase(objectName)) == 0)
+		return objectName;
+
+	if ((array = ____container(objectName, length))->exists == false)
+	{
+		// Creating the element just past the known end of the array may join it to elements already
+		// beyond it so the count has to be found again
+		if (create && array->known == atol(&objectName[length]))
+			array->known = -1;
+		return objectName;
+	}
+
+	index = atol(&objectName[length]);
+	if (index < array->count && array->slot[index] != C_EMPTY_SLOT)
+		sprintf(fileName, "%s#%u", array->base, array->slot[index]);
+	else if (index < array->count)
+	{
+		// An element removed earlier. It gets a new slot when created again.
+		sprintf(fileName, "%s#%u", array->base, array->next);
+		if (create)
+		{
+			array->slot[index] = array->next++;
+			____saveContainer(array);
+		}
+	}
+	else if (index == array->count)
+	{
+		// An element that does not exist yet. Its file is the next unused slot.
+		sprintf(fileName, "%s#%u", array->base, array->next);
+		if (create)
+		{
+			array->slot = my_realloc(array->slot, (array->count + 2) * sizeof(uint));
+			array->slot[array->count++] = array->next++;
+			____saveContainer(array);
+		}
+	}
+
+	// Elements beyond the end of the array are outside the container
+	else return objectName;
+
+	return fileName;
+}
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : IRIS_ObjectExists
+//
+// DESCRIPTION:	Check that an object exists in the file system
+//
+// PARAMETERS:	objectName	<=	The object name
+//
+// RETURNS:		True if found
+//
+//-----------------------------------------------------------------------------
+//
+bool IRIS_ObjectExists(char * objectName)
+{
+	char fileName[100];
+
+	return ____fileExists(IRIS_ObjectFileName(objectName, fileName, false));
+}
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : IRIS_ArrayCount
+//
+// DESCRIPTION:	Return the number of elements of an object array if known without
+//				looking at the file system
+//
+// PARAMETERS:	base	<=	The array object name without any index
+//
+// RETURNS:		The count or -1 if not known
+//
+//-----------------------------------------------------------------------------
+//
+int IRIS_ArrayCount(char * base)
+{
+	uint i;
+	T_CONTAINER * array = ____container(base, strlen(base));
+
+	if (array->exists == false)
+		return array->known;
+
+	// Like an array stored one file per index, the array ends at the first element missing
+	for (i = 0; i < array->count && array->slot[i] != C_EMPTY_SLOT; i++);
+	return (int) i;
+}
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : ____setTagValue
+//
+// DESCRIPTION:	Update a simple tag:value within an allocated object data buffer.
+//				The tag is added to the end of the object if not found.
+//
+// PARAMETERS:	objectData	<=>	The object data. It may be reallocated.
+//				tag			<=	The tag name
+//				value		<=	The new value. If NULL, the tag:value is deleted.
+//
+// RETURNS:		None
+//
+//-----------------------------------------------------------------------------
+//
+static void ____setTagValue(char ** objectData, char * tag, char * value)
+{
+	char * data = *objectData;
+	char * ptr, * ptr2;
+	char * newData;
+	char search[100];
+
+	// Look for the separator preceding the tag
+	sprintf(search, ",%.*s:", (int) sizeof(search) - 3, tag);
+	if ((ptr = strstr(data, search)) == NULL && data[0] == '{' && strncmp(&data[1], &search[1], strlen(&search[1])) == 0)
+		ptr = data;
+
+	if (ptr)
+	{
+		// Find the end of the existing tag:value. It must be a simple value
+		if ((ptr2 = strchr(ptr+1, ',')) == NULL && (ptr2 = strchr(ptr+1, '}')) == NULL)
+			return;
+
+		// Delete the tag:value and one of its separators
+		if (value == NULL)
+		{
+			if (*ptr == '{')
+			{
+				ptr++;
+				if (*ptr2 == ',') ptr2++;
+			}
+			memmove(ptr, ptr2, strlen(ptr2) + 1);
+			return;
+		}
+		ptr++;
+	}
+	else if (value == NULL || (ptr = ptr2 = strrchr(data, '}')) == NULL)
+		return;
+
+	newData = my_malloc(strlen(data) + strlen(tag) + strlen(value) + 3);
+	sprintf(newData, "%.*s%s%s:%s%s", ptr - data, data, (*ptr2 == '}' && ptr == ptr2)?",":"", tag, value, ptr2);
+	my_free(data);
+	*objectData = newData;
+}
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : Object journals
+//
+// DESCRIPTION:	Updates of a tag within a DATA or CONFIG object are appended to a journal
+//				file next to the object (the object name followed by ".J") instead of
+//				rewriting the tail of the object file for every update.
+//
+//				The journal starts with C_JOURNAL_MAGIC followed by records of
+//				"tag:value\0" for an update or "tag\0" for a deletion. The records are
+//				replayed in order every time the object is loaded.
+//
+//				Replaying a record twice gives the same result, so a journal is folded
+//				back into its object by writing the replayed object first and removing
+//				the journal after.
+//
+//-----------------------------------------------------------------------------
+//
+static void ____journalName(char * objectName, char * journalName)
+{
+	sprintf(journalName, "%s%s", objectName, journalTrailer);
+}
+
+static void ____rememberJournal(char * objectName)
+{
+	int i;
+
+	for (i = 0; i < C_MAX_JOURNALS && journalObject[i]; i++)
+		if (strcmp(journalObject[i], objectName) == 0) return;
+
+	// If we are remembering too many journals, compact the oldest one to make room
+	if (i == C_MAX_JOURNALS)
+	{
+		IRIS_CompactObjectJournal(journalObject[0]);
+		for (i = 0; i < C_MAX_JOURNALS && journalObject[i]; i++);
+	}
+
+	UtilStrDup(&journalObject[i], objectName);
+}
+
+//
+// Apply journal records to an object. A record cut short by a power failure has no terminator and is ignored.
+// The records must be followed by a '\0' beyond 'size'.
+//
+static void ____applyRecords(char ** objectData, char * records, uint size)
+{
+	char * record;
+
+	for (record = records; record < &records[size] && (record + strlen(record)) < &records[size]; record += strlen(record) + 1)
+	{
+		char * value = strchr(record, ':');
+
+		if (record[0] == '\0') continue;
+		if (value) *value++ = '\0';
+		____setTagValue(objectData, record, value);
+	}
+}
+
+static void ____replayJournal(char * objectName, char ** objectData, uint * length)
+{
+	char journalName[100];
+	char * journal;
+	uint size;
+	FILE_HANDLE handle;
+
+	____journalName(objectName, journalName);
+	handle = open(journalName, FH_RDONLY);
+	if (FH_ERR(handle))
+		return;
+
+	size = lseek(handle, 0, SEEK_END);
+#ifdef _DEBUG
+	size = ftell(handle);
+#endif
+	lseek(handle, 0, SEEK_SET);
+
+	journal = my_malloc(size + 1);
+	read(handle, journal, size);
+	journal[size] = '\0';
+	close(handle);
+
+	if (size && journal[0] == C_JOURNAL_MAGIC)
+	{
+		____applyRecords(objectData, &journal[1], size - 1);
+		*length = strlen(*objectData);
+		____rememberJournal(objectName);
+	}
+
+	my_free(journal);
+}
+
+//
+// Apply the changes of the current batch that are not committed yet
+//
+static void ____replayBatch(char * objectName, char ** objectData, uint * length)
+{
+	int i;
+
+	for (i = 0; i < C_MAX_BATCH_OBJECTS && batch[i].objectName; i++)
+	{
+		if (strcmp(batch[i].objectName, objectName) == 0)
+		{
+			char * records = my_malloc(batch[i].length + 1);
+
+			// The records are modified while they are applied
+			memcpy(records, batch[i].records, batch[i].length);
+			records[batch[i].length] = '\0';
+			____applyRecords(objectData, records, batch[i].length);
+			*length = strlen(*objectData);
+			my_free(records);
+			break;
+		}
+	}
+}
+
+//
+// Append records to the journal of an object in one write
+//
+static void ____appendJournal(char * objectName, char * records, uint length)
+{
+	char journalName[100];
+	long size;
+	FILE_HANDLE handle;
+
+	____journalName(objectName, journalName);
+	handle = open(journalName, FH_APPEND);
+	if (FH_ERR(handle))
+		return;
+
+	// A new journal starts with its magic byte
+	size = lseek(handle, 0, SEEK_END);
+#ifdef _DEBUG
+	size = ftell(handle);
+#endif
+	if (size == 0)
+	{
+		char magic = C_JOURNAL_MAGIC;
+		write(handle, &magic, 1);
+		size++;
+	}
+
+	write(handle, records, length);
+	close(handle);
+
+	IRIS_InvalidateObjectCache(objectName);
+
+	if ((size + length) > C_JOURNAL_MAX_SIZE)
+		IRIS_CompactObjectJournal(objectName);
+	else
+		____rememberJournal(objectName);
+}
+
+//
+// Stage records within the current batch. An earlier update of the same tag is replaced.
+//
+static void ____stageRecord(char * objectName, char * record, uint length)
+{
+	int i;
+	T_BATCH * entry;
+	char * ptr;
+	uint tagLength;
+
+	for (i = 0; i < C_MAX_BATCH_OBJECTS && batch[i].objectName; i++)
+		if (strcmp(batch[i].objectName, objectName) == 0) break;
+
+	// If too many objects are being updated, commit what we have so far
+	if (i == C_MAX_BATCH_OBJECTS)
+	{
+		IRIS_CommitBatch(true);
+		i = 0;
+	}
+
+	entry = &batch[i];
+	if (entry->objectName == NULL)
+		UtilStrDup(&entry->objectName, objectName);
+
+	// Coalesce updates of the same tag
+	for (tagLength = 0; record[tagLength] && record[tagLength] != ':'; tagLength++);
+	for (ptr = entry->records; ptr && ptr < &entry->records[entry->length]; )
+	{
+		uint recordLength = strlen(ptr) + 1;
+
+		if (strncmp(ptr, record, tagLength) == 0 && (ptr[tagLength] == ':' || ptr[tagLength] == '\0'))
+		{
+			memmove(ptr, ptr + recordLength, &entry->records[entry->length] - (ptr + recordLength));
+			entry->length -= recordLength;
+		}
+		else ptr += recordLength;
+	}
+
+	entry->records = entry->records? my_realloc(entry->records, entry->length + length):my_malloc(length);
+	memcpy(&entry->records[entry->length], record, length);
+	entry->length += length;
+
+	IRIS_InvalidateObjectCache(objectName);
+}
+
+static void ____dropBatch(int i, T_BATCH * entry)
+{
+	// Hand the entry over to the caller or release it
+	if (entry)
+		*entry = batch[i];
+	else
+	{
+		UtilStrDup(&batch[i].objectName, NULL);
+		if (batch[i].records) my_free(batch[i].records);
+	}
+	memmove(&batch[i], &batch[i+1], (C_MAX_BATCH_OBJECTS - i - 1) * sizeof(T_BATCH));
+	memset(&batch[C_MAX_BATCH_OBJECTS-1], 0, sizeof(T_BATCH));
+}
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : IRIS_JournalTagValue
+//
+// DESCRIPTION:	Append a tag update to the journal of an object. Within a batch, the
+//				update is staged in memory until the batch is committed.
+//
+// PARAMETERS:	objectName	<=	The object name
+//				tag			<=	The tag name
+//				value		<=	The new value. If NULL, the tag:value is deleted.
+//
+// RETURNS:		None
+//
+//-----------------------------------------------------------------------------
+//
+void IRIS_JournalTagValue(char * objectName, char * tag, char * value)
+{
+	uint length = strlen(tag) + (value?strlen(value)+1:0) + 1;
+	char * record = my_malloc(length);
+	char fileName[100];
+
+	sprintf(record, "%s%s%s", tag, value?":":"", value?value:"");
+	objectName = IRIS_ObjectFileName(objectName, fileName, false);
+
+	if (batchLevel)
+		____stageRecord(objectName, record, length);
+	else
+		____appendJournal(objectName, record, length);
+
+	my_free(record);
+}
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : IRIS_BeginBatch
+//
+// DESCRIPTION:	Start staging the permanent data updates in memory. Batches may be nested
+//				in which case only the outermost batch is committed.
+//
+// PARAMETERS:	None
+//
+// RETURNS:		None
+//
+//-----------------------------------------------------------------------------
+//
+void IRIS_BeginBatch(void)
+{
+	batchLevel++;
+}
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : IRIS_CommitBatch
+//
+// DESCRIPTION:	End a batch and write all its staged updates.
+//
+//				All updates are first written to a batch file with a completion marker,
+//				then appended to the journal of each object once, then the batch file is
+//				removed. If power fails before the batch file is complete, none of the
+//				updates are applied. If it fails after, IRIS_RecoverBatch() applies them all.
+//
+// PARAMETERS:	early	<=	If true, the staged updates are written but the batch remains open
+//
+// RETURNS:		None
+//
+//-----------------------------------------------------------------------------
+//
+void IRIS_CommitBatch(bool early)
+{
+	int i;
+	uint size = 2;
+	char * data;
+	char * ptr;
+	FILE_HANDLE handle;
+
+	if (batchLevel == 0 || (early == false && --batchLevel) || batch[0].objectName == NULL)
+		return;
+
+	// Build the batch file: the magic byte, then "name\0records\0" for each object, then the completion marker
+	for (i = 0; i < C_MAX_BATCH_OBJECTS && batch[i].objectName; i++)
+		size += strlen(batch[i].objectName) + 1 + batch[i].length + 1;
+
+	ptr = data = my_malloc(size);
+	*ptr++ = C_JOURNAL_MAGIC;
+	for (i = 0; i < C_MAX_BATCH_OBJECTS && batch[i].objectName; i++)
+	{
+		strcpy(ptr, batch[i].objectName);
+		ptr += strlen(ptr) + 1;
+		memcpy(ptr, batch[i].records, batch[i].length);
+		ptr += batch[i].length;
+		*ptr++ = '\0';
+	}
+	*ptr = C_BATCH_COMMITTED;
+
+	handle = open((char *) batchFile, FH_NEW);
+	if (FH_OK(handle))
+	{
+		write(handle, data, size);
+		close(handle);
+	}
+	my_free(data);
+
+	// Now update each journal once. The entry is taken out first as the journal may get compacted.
+	while (batch[0].objectName)
+	{
+		T_BATCH entry;
+
+		____dropBatch(0, &entry);
+		____appendJournal(entry.objectName, entry.records, entry.length);
+		UtilStrDup(&entry.objectName, NULL);
+		my_free(entry.records);
+	}
+
+	_remove(batchFile);
+}
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : IRIS_RecoverBatch
+//
+// DESCRIPTION:	Apply a complete batch that was interrupted by a power failure. Called at start up.
+//
+// PARAMETERS:	None
+//
+// RETURNS:		None
+//
+//-----------------------------------------------------------------------------
+//
+void IRIS_RecoverBatch(void)
+{
+	char * data;
+	char * ptr;
+	uint size;
+	FILE_HANDLE handle;
+
+	handle = open((char *) batchFile, FH_RDONLY);
+	if (FH_ERR(handle))
+		return;
+
+	size = lseek(handle, 0, SEEK_END);
+#ifdef _DEBUG
+	size = ftell(handle);
+#endif
+	lseek(handle, 0, SEEK_SET);
+
+	data = my_malloc(size + 1);
+	read(handle, data, size);
+	data[size] = '\0';
+	close(handle);
+
+	if (size > 2 && data[0] == C_JOURNAL_MAGIC && data[size-1] == C_BATCH_COMMITTED)
+	{
+		for (ptr = &data[1]; ptr < &data[size-1] && *ptr;)
+		{
+			char * objectName = ptr;
+			char * records;
+
+			ptr += strlen(ptr) + 1;
+			for (records = ptr; ptr < &data[size-1] && *ptr; ptr += strlen(ptr) + 1);
+
+			// A leading terminator separates the records from any record cut short in the journal
+			____appendJournal(objectName, "", 1);
+			____appendJournal(objectName, records, ptr - records);
+			ptr++;
+		}
+	}
+
+	my_free(data);
+	_remove(batchFile);
+}
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : IRIS_ResetObjectJournal
+//
+// DESCRIPTION:	Discard the journal of an object after the object file has been rewritten
+//				or removed and drop any cached copy of the object.
+//
+// PARAMETERS:	objectName	<=	The object name
+//
+// RETURNS:		None
+//
+//-----------------------------------------------------------------------------
+//
+void IRIS_ResetObjectJournal(char * objectName)
+{
+	int i;
+	char journalName[100];
+	char fileName[100];
+
+	objectName = IRIS_ObjectFileName(objectName, fileName, false);
+
+	IRIS_InvalidateObjectCache(objectName);
+
+	// The object file already includes any staged updates
+	for (i = 0; i < C_MAX_BATCH_OBJECTS && batch[i].objectName; i++)
+	{
+		if (strcmp(batch[i].objectName, objectName) == 0)
+		{
+			____dropBatch(i, NULL);
+			break;
+		}
+	}
+
+	for (i = 0; i < C_MAX_JOURNALS && journalObject[i]; i++)
+	{
+		if (strcmp(journalObject[i], objectName) == 0)
+		{
+			UtilStrDup(&journalObject[i], NULL);
+			memmove(&journalObject[i], &journalObject[i+1], (C_MAX_JOURNALS - i - 1) * sizeof(char *));
+			journalObject[C_MAX_JOURNALS-1] = NULL;
+			break;
+		}
+	}
+
+	____journalName(objectName, journalName);
+	_remove(journalName);
+}
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : IRIS_CompactObjectJournal
+//
+// DESCRIPTION:	Fold the journal of an object back into the object file. If objectName
+//				is NULL, all remembered journals are compacted.
+//
+// PARAMETERS:	objectName	<=	The object name or NULL
+//
+// RETURNS:		None
+//
+//-----------------------------------------------------------------------------
+//
+void IRIS_CompactObjectJournal(char * objectName)
+{
+	char * data;
+	char * name = NULL;
+	char fileName[100];
+	uint length;
+	FILE_HANDLE handle;
+
+	if (objectName == NULL)
+	{
+		while (journalObject[0])
+			IRIS_CompactObjectJournal(journalObject[0]);
+		return;
+	}
+
+	// The name may belong to the journal list which is updated below
+	UtilStrDup(&name, IRIS_ObjectFileName(objectName, fileName, false));
+
+	// Only an object file can be compacted. Make sure we do not pick up an internal or remote object instead.
+	handle = open(name, FH_RDONLY);
+	if (FH_OK(handle))
+	{
+		close(handle);
+		if ((data = IRIS_LoadObjectData(name, &length)) != NULL)
+		{
+			IRIS_PutNamedObjectData(data, length, name);
+			my_free(data);
+		}
+	}
+
+	IRIS_ResetObjectJournal(name);
+	UtilStrDup(&name, NULL);
+}
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : IRIS_LoadObjectData
+//
+// DESCRIPTION:	Look for an object in the file system.
+//				If found, read the object into an allocated memory.
+//				The object cache is neither used nor updated so scans of all the
+//				objects do not push the working set out of the cache.
+//
+// PARAMETERS:	objectName	<=	The name of the file (object)
+//				length		=>	Updated with the object length on exit
+//
+// RETURNS:		Pointer to an allocated memory structure representing file
+//				object data in memory
+//
+//-----------------------------------------------------------------------------
+//
+char * IRIS_LoadObjectData(char * objectName, unsigned int * length)
+{
+	char temp = 0;
+	char * data;
+	FILE_HANDLE handle;
+
+	// Open the file
+	handle = open(objectName, FH_RDONLY);
+	if (FH_ERR(handle))
+	{
+		if ((data = IRIS_GetInternalObjectData(objectName, length)) != NULL)
+			return data;
+		if (objectName == currentObject)
+			IRIS_GetExternalObjectData(objectName);
+		handle = open(objectName, FH_RDONLY);
+		if (FH_ERR(handle))
+			return NULL;
+	}
+
+	// Do a simple check first
+	read(handle, &temp, 1);
+	if (temp != '{') {
+		close(handle);
+		return NULL;
+	}
+
+	// Read the entire object
+	*length = lseek(handle, 0, SEEK_END);
+#ifdef _DEBUG
+	*length = ftell(handle);
+#endif
+	lseek(handle, 0, SEEK_SET);
+
+	data = my_malloc((*length)+1);
+	read(handle, data, *length);
+	data[*length] = '\0';
+
+	// House keep and finish
+	close(handle);
+
+	// Just in case there are added data towards the end durign inserts and deletion operations....
+	*length = strlen(data);
+
+	// Apply any changes journalled since the object was last written and those of the current batch
+	____replayJournal(objectName, &data, length);
+	____replayBatch(objectName, &data, length);
+
+	return data;
+}
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : IRIS_LockObjectData
+//
+// DESCRIPTION:	Look for an object in the object cache first. If not cached, load it
+//				from the file system and keep it in the cache for the next access.
+//
+//				The cache holds up to C_OBJECT_CACHE_ENTRIES objects within a memory
+//				budget of C_OBJECT_CACHE_BUDGET bytes. When full, the least recently
+//				used object that is not locked is dropped.
+//
+//				The returned data is shared and must not be modified or freed. Release
+//				it with IRIS_UnlockObjectData() when done.
+//
+// PARAMETERS:	objectName	<=	The name of the file (object)
+//				length		=>	Updated with the object length on exit
+//
+// RETURNS:		Pointer to the object data or NULL if not found
+//
+//-----------------------------------------------------------------------------
+//
+static void ____freeTagIndex(T_TAG_INDEX * index);
+static void ____dataChanged(char * objectName);
+
+static void ____freeCachedObject(T_OBJECT_CACHE * entry)
+{
+	if (entry->stale == false)
+		objectCacheSize -= entry->length;
+	____freeTagIndex(entry->index);
+	UtilStrDup(&entry->name, NULL);
+	UtilStrDup(&entry->data, NULL);
+	memset(entry, 0, sizeof(T_OBJECT_CACHE));
+}
+
+static T_OBJECT_CACHE * ____findCachedObject(char * objectName)
+{
+	int i;
+
+	for (i = 0; i < C_OBJECT_CACHE_ENTRIES; i++)
+	{
+		if (objectCache[i].data && objectCache[i].stale == false && strcmp(objectCache[i].name, objectName) == 0)
+			return &objectCache[i];
+	}
+
+	return NULL;
+}
+
+static bool ____isCachedObject(char * objectData)
+{
+	int i;
+
+	for (i = 0; i < C_OBJECT_CACHE_ENTRIES; i++)
+	{
+		if (objectCache[i].data == objectData)
+			return true;
+	}
+
+	return false;
+}
+
+static T_OBJECT_CACHE * ____newCachedObject(uint length)
+{
+	int i;
+	T_OBJECT_CACHE * entry;
+
+	if (length > C_OBJECT_CACHE_MAX_OBJECT)
+		return NULL;
+
+	for(;;)
+	{
+		// Look for a free slot and the least recently used unlocked object at the same time
+		for (i = 0, entry = NULL; i < C_OBJECT_CACHE_ENTRIES; i++)
+		{
+			if (objectCache[i].data == NULL)
+			{
+				if ((objectCacheSize + length) <= C_OBJECT_CACHE_BUDGET)
+					return &objectCache[i];
+			}
+			else if (objectCache[i].locks == 0 && (entry == NULL || objectCache[i].lastUsed < entry->lastUsed))
+				entry = &objectCache[i];
+		}
+
+		// Everything is locked. Do not cache this one.
+		if (entry == NULL)
+			return NULL;
+
+		____freeCachedObject(entry);
+	}
+}
+
+char * IRIS_LockObjectData(char * objectName, unsigned int * length)
+{
+	T_OBJECT_CACHE * entry;
+	char * name = NULL;
+	char * data;
+	char fileName[100];
+	char * file;
+
+	if (!objectName || !length) return NULL;
+
+	// Objects are cached by their file name. It differs from the object name for array container elements.
+	file = IRIS_ObjectFileName(objectName, fileName, false);
+
+	// Use the cached copy if available
+	if ((entry = ____findCachedObject(file)) != NULL)
+	{
+		objectCacheHits++;
+		entry->lastUsed = ++objectCacheTick;
+		entry->locks++;
+		*length = entry->length;
+		return entry->data;
+	}
+	objectCacheMisses++;
+
+	// Keep our own copy of the name. Loading an internal object can reallocate currentObject which may be what we were given.
+	UtilStrDup(&name, file);
+
+	// Load it from the file system. An array container element carries the name of its current index.
+	if ((data = IRIS_LoadObjectData(file, length)) != NULL && file != objectName)
+	{
+		____setTagValue(&data, "NAME", objectName);
+		*length = strlen(data);
+	}
+
+	if (data && (entry = ____newCachedObject(*length)) != NULL)
+	{
+		entry->name = name;
+		entry->data = data;
+		entry->length = *length;
+		entry->lastUsed = ++objectCacheTick;
+		entry->locks = 1;
+		objectCacheSize += *length;
+		return data;
+	}
+
+	// Not found or not cachable. The caller gets its own copy that IRIS_UnlockObjectData() will free
+	my_free(name);
+	return data;
+}
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : IRIS_UnlockObjectData
+//
+// DESCRIPTION:	Release an object data reference obtained by IRIS_LockObjectData()
+//
+// PARAMETERS:	objectData	<=	The object data reference
+//
+// RETURNS:		None
+//
+//-----------------------------------------------------------------------------
+//
+void IRIS_UnlockObjectData(char * objectData)
+{
+	int i;
+
+	if (objectData == NULL) return;
+
+	for (i = 0; i < C_OBJECT_CACHE_ENTRIES; i++)
+	{
+		if (objectCache[i].data == objectData)
+		{
+			if (objectCache[i].locks) objectCache[i].locks--;
+			if (objectCache[i].locks == 0 && objectCache[i].stale)
+				____freeCachedObject(&objectCache[i]);
+			return;
+		}
+	}
+
+	// This was never cached
+	my_free(objectData);
+}
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : IRIS_InvalidateObjectCache
+//
+// DESCRIPTION:	Drop an object from the object cache after it changed in the file system.
+//				Objects still locked become stale and are released with their last lock.
+//
+// PARAMETERS:	objectName	<=	The name of the object or NULL for all objects
+//
+// RETURNS:		None
+//
+//-----------------------------------------------------------------------------
+//
+void IRIS_InvalidateObjectCache(char * objectName)
+{
+	int i;
+	char fileName[100];
+
+	____dataChanged(objectName);
+	objectName = IRIS_ObjectFileName(objectName, fileName, false);
+
+	for (i = 0; i < C_OBJECT_CACHE_ENTRIES; i++)
+	{
+		if (objectCache[i].data && objectCache[i].stale == false && (objectName == NULL || strcmp(objectCache[i].name, objectName) == 0))
+		{
+			if (objectCache[i].locks)
+			{
+				objectCacheSize -= objectCache[i].length;
+				objectCache[i].stale = true;
+			}
+			else
+				____freeCachedObject(&objectCache[i]);
+		}
+	}
+}
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : IRIS_ObjectCacheStats
+//
+// DESCRIPTION:	Returns the object cache counters
+//
+// PARAMETERS:	hits		=>	Number of object accesses served from memory
+//				misses		=>	Number of object accesses that went to the file system
+//
+// RETURNS:		None
+//
+//-----------------------------------------------------------------------------
+//
+void IRIS_ObjectCacheStats(ulong * hits, ulong * misses)
+{
+	if (hits) *hits = objectCacheHits;
+	if (misses) *misses = objectCacheMisses;
+}
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : IRIS_GetObjectData
+//
+// DESCRIPTION:	Look for an object in the object cache or the file system.
+//				If found, copy the object into an allocated memory
+//
+// PARAMETERS:	objectName	<=	The name of the file (object)
+//				length		=>	Updated with the object length on exit
+//
+// RETURNS:		Pointer to an allocated memory structure representing file
+//				object data in memory
+//
+//-----------------------------------------------------------------------------
+//
+char * IRIS_GetObjectData(char * objectName, unsigned int * length)
+{
+	char * data;
+	char * copy;
+
+	if ((data = IRIS_LockObjectData(objectName, length)) == NULL)
+		return NULL;
+
+	// If it was too big to cache, the caller can have it as is
+	if (____isCachedObject(data) == false)
+		return data;
+
+	copy = my_malloc((*length)+1);
+	memcpy(copy, data, *length);
+	copy[*length] = '\0';
+
+	IRIS_UnlockObjectData(data);
+
+	return copy;
+}
+
+// Remove an object. An element of an array container either leaves its slot empty or the following elements move down one index.
+static int ____removeObject(char * objectName, bool shift)
+{
+	char fileName[100];
+	char * file = IRIS_ObjectFileName(objectName, fileName, false);
+
+	IRIS_ResetObjectJournal(file);
+	IRIS_UpdateManifest(file, NULL, 0);
+
+	// Outside a container, the array now ends at the removed element
+	if (file == objectName && ____arrayBase(objectName))
+	{
+		T_CONTAINER * array = ____container(objectName, ____arrayBase(objectName));
+
+		if (array->known > atol(&objectName[____arrayBase(objectName)]))
+			array->known = atol(&objectName[____arrayBase(objectName)]);
+	}
+
+	// Remove the element from its array container
+	else if (file != objectName)
+	{
+		int length = ____arrayBase(objectName);
+		T_CONTAINER * array = ____container(objectName, length);
+		uint index = atol(&objectName[length]);
+
+		if (index < array->count && shift)
+		{
+			memmove(&array->slot[index], &array->slot[index+1], (array->count - index - 1) * sizeof(uint));
+			array->count--;
+			____saveContainer(array);
+			____invalidateCachedArray(array->base);
+		}
+		else if (index < array->count)
+		{
+			// The other elements keep their index. Empty slots at the end are dropped.
+			array->slot[index] = C_EMPTY_SLOT;
+			while (array->count && array->slot[array->count-1] == C_EMPTY_SLOT)
+				array->count--;
+			____saveContainer(array);
+		}
+	}
+
+	return _remove(file);
+}
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : IRIS_RemoveObject
+//
+// DESCRIPTION:	Remove an object from the file system and the object cache.
+//				The following elements of an array keep their index.
+//
+// PARAMETERS:	objectName	<=	The name of the file (object)
+//
+// RETURNS:		The result of the file removal. -1 if not found.
+//
+//-----------------------------------------------------------------------------
+//
+int IRIS_RemoveObject(char * objectName)
+{
+	return ____removeObject(objectName, false);
+}
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : IRIS_DownloadResourceObject
+//
+// DESCRIPTION:	Look for a resource object (ie object needed by another object) in the file system.
+//				If found returns OK. If not, contacts the remote host and grabs it
+//
+// PARAMETERS:	objectName	<=	The name of the file (resource object)
+//
+// RETURNS:		TRUE if available or FALSE if not
+//
+//-----------------------------------------------------------------------------
+//
+bool IRIS_DownloadResourceObject(char * objectName)
+{
+	FILE_HANDLE handle;
+
+	if (!objectName) return false;
+
+	handle = open(objectName, FH_RDONLY);
+
+	if (FH_ERR(handle))
+	{
+		if (IRIS_GetInternalObjectData(objectName, NULL) != NULL)
+			return true;
+
+		if (objectName == currentObject)
+		{
+			IRIS_GetExternalObjectData(objectName);
+			handle = open(objectName, FH_RDONLY);
+		}
+	}
+
+	if (FH_ERR(handle))
+	{
+		if (objectName != currentObject)
+		{
+			char * myPrevObject = prevObject;
+			prevObject = currentObject;
+			IRIS_GetExternalObjectData(objectName);
+			prevObject = myPrevObject;
+
+			handle = open(objectName, FH_RDONLY);
+		}
+
+		if (FH_ERR(handle))
+			return false;
+	}
+
+	close(handle);
+	return true;
+}
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : IRIS_GetTypeObjectData
+//
+// DESCRIPTION:	Look for the count'th object in the file system with a TYPE starting with type.
+//				The objects of the F: drive are counted first. If there are not enough, the
+//				objects of the I: drive are counted from the start. Within a drive, objects
+//				come in the order the manifest first recorded them. When it is rebuilt, that
+//				is the directory order.
+//
+// PARAMETERS:	count <= 
+//						=>	Updated with the object length on exit
+//
+// RETURNS:		Pointer to an allocated memory structure representing file
+//				object data in memory
+//
+//-----------------------------------------------------------------------------
+//
+#ifdef _DEBUG
+int dir_get_first(char * filename)
+{
+	dir = 0;
+//	strcpy(filename, "SGB");
+	strcpy(filename, "iPAY");
+	return 0;
+}
+
+int dir_get_next(char * filename)
+{
+	if (dir == 0)
+	{
+		strcpy(filename, "iECR");
+		dir++;
+		return 0;
+	}
+	else if (dir == 1)
+	{
+		strcpy(filename, "iSCAN");
+		dir++;
+		return 0;
+	}
+	else if (dir == 2)
+	{
+		strcpy(filename, "iVSTOCK");
+		dir++;
+		return 0;
+	}
+
+	return 1;
+}
+
+#endif
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : Object manifest
+//
+// DESCRIPTION:	The manifest lists the TYPE, GROUP, VERSION, size and SIGN of every object
+//				so objects of a given type can be found without opening any object file.
+//
+//				It is held in memory and kept in the file __MANIFEST.J as records of
+//				"NAME\tTYPE\tGROUP\tVERSION\tSIZE\tSIGN\n" appended whenever an object is
+//				written, or "-NAME\n" when an object is removed. A later record of the same
+//				name replaces an earlier one. If the manifest file does not exist, it is
+//				rebuilt from a directory scan. A record is only written when the TYPE, GROUP,
+//				VERSION or SIGN of an object changes so the SIZE is as of the last record.
+//
+//-----------------------------------------------------------------------------
+//
+static char * ____manifestString(char * data, uint length, char * name, char * buffer, int size)
+{
+	char * value = IRIS_GetStringValue(data, length, name, false);
+
+	buffer[0] = '\0';
+	if (value && value[0] == 0)
+		sprintf(buffer, "%.*s", size - 1, &value[4]);
+	IRIS_DeallocateStringValue(value);
+
+	return buffer;
+}
+
+static int ____findManifest(char * objectName)
+{
+	int i;
+
+	for (i = 0; i < manifestCount; i++)
+		if (strcmp(manifest[i].record, objectName) == 0) return i;
+
+	return -1;
+}
+
+// Apply a manifest record to the in memory manifest. The record is modified.
+static void ____applyManifest(char * record)
+{
+	int i;
+	T_MANIFEST * entry;
+	char * ptr;
+
+	// Removal record
+	if (record[0] == '-')
+	{
+		if ((i = ____findManifest(&record[1])) != -1)
+		{
+			my_free(manifest[i].record);
+			memmove(&manifest[i], &manifest[i+1], (manifestCount - i - 1) * sizeof(T_MANIFEST));
+			manifestCount--;
+			manifestDead += 2;
+		}
+		return;
+	}
+
+	// Terminate the name
+	if ((ptr = strchr(record, '\t')) == NULL)
+		return;
+	*ptr = '\0';
+
+	// Replace or add the entry
+	if ((i = ____findManifest(record)) != -1)
+	{
+		my_free(manifest[i].record);
+		manifestDead++;
+	}
+	else
+	{
+		if (manifestCount == manifestMax)
+		{
+			manifestMax += 32;
+			manifest = manifest? my_realloc(manifest, manifestMax * sizeof(T_MANIFEST)):my_malloc(manifestMax * sizeof(T_MANIFEST));
+		}
+		i = manifestCount++;
+	}
+
+	entry = &manifest[i];
+	entry->record = my_malloc((ptr - record) + 1 + strlen(ptr+1) + 1);
+	memcpy(entry->record, record, (ptr - record) + 1 + strlen(ptr+1) + 1);
+	ptr = entry->record + (ptr - record) + 1;
+
+	// Split the fields
+	entry->type = ptr;
+	entry->group = entry->version = entry->sign = "";
+	entry->size = 0;
+	if ((ptr = strchr(ptr, '\t')) != NULL)
+	{
+		*ptr++ = '\0', entry->group = ptr;
+		if ((ptr = strchr(ptr, '\t')) != NULL)
+		{
+			*ptr++ = '\0', entry->version = ptr;
+			if ((ptr = strchr(ptr, '\t')) != NULL)
+			{
+				*ptr++ = '\0', entry->size = atol(ptr);
+				if ((ptr = strchr(ptr, '\t')) != NULL)
+					*ptr++ = '\0', entry->sign = ptr;
+			}
+		}
+	}
+}
+
+static void ____appendManifest(char * record)
+{
+	FILE_HANDLE handle = open((char *) manifestFile, FH_APPEND);
+
+	if (FH_OK(handle))
+	{
+		write(handle, record, strlen(record));
+		write(handle, "\n", 1);
+		close(handle);
+	}
+}
+
+// Write the whole manifest without any replaced records
+static void ____writeManifest(void)
+{
+	int i;
+	char record[300];
+	FILE_HANDLE handle = open((char *) manifestFile, FH_NEW);
+
+	if (FH_ERR(handle))
+		return;
+
+	for (i = 0; i < manifestCount; i++)
+	{
+		sprintf(record, "%.50s\t%.50s\t%.50s\t%.50s\t%u\t%.50s\n", manifest[i].record, manifest[i].type, manifest[i].group, manifest[i].version, manifest[i].size, manifest[i].sign);
+		write(handle, record, strlen(record));
+	}
+
+	close(handle);
+	manifestDead = 0;
+}
+
+static void ____loadManifest(void)
+{
+	char * data;
+	char * record;
+	char * next;
+	uint size;
+	FILE_HANDLE handle;
+
+	if (manifest) return;
+
+	manifestMax = 32;
+	manifest = my_malloc(manifestMax * sizeof(T_MANIFEST));
+
+	handle = open((char *) manifestFile, FH_RDONLY);
+	if (FH_OK(handle))
+	{
+		size = lseek(handle, 0, SEEK_END);
+#ifdef _DEBUG
+		size = ftell(handle);
+#endif
+		lseek(handle, 0, SEEK_SET);
+
+		data = my_malloc(size + 1);
+		read(handle, data, size);
+		data[size] = '\0';
+		close(handle);
+
+		// Only complete records are applied
+		for (record = data; (next = strchr(record, '\n')) != NULL; record = next + 1)
+		{
+			*next = '\0';
+			if (record[0]) ____applyManifest(record);
+		}
+
+		my_free(data);
+	}
+
+	// If there is no manifest yet, build it from the objects in the file system
+	else
+	{
+		int i, j;
+		char fileName[50];
+		uint length;
+
+		for (j = 0; j < 2; j++)
+		{
+			strcpy(fileName, j?"I:":"F:");
+			for (i = dir_get_first(fileName); i == 0; i = dir_get_next(fileName))
+			{
+				if ((data = IRIS_LoadObjectData(fileName, &length)) != NULL)
+				{
+					if (data[0] == '{' && data[length-1] == '}')
+						IRIS_UpdateManifest(fileName, data, length);
+					my_free(data);
+				}
+			}
+		}
+	}
+
+	// Keep the manifest file tidy
+	if (manifestDead > C_MANIFEST_MIN_DEAD && manifestDead > manifestCount)
+		____writeManifest();
+}
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : IRIS_UpdateManifest
+//
+// DESCRIPTION:	Record an object written to the file system in the object manifest
+//
+// PARAMETERS:	objectName	<=	The object name
+//				objectData	<=	The object data. If NULL, the object has been removed.
+//				length		<=	The object length
+//
+// RETURNS:		None
+//
+//-----------------------------------------------------------------------------
+//
+void IRIS_UpdateManifest(char * objectName, char * objectData, uint length)
+{
+	int i;
+	char record[300];
+	char type[51], group[51], version[51], sign[51];
+
+	____loadManifest();
+
+	if (objectData == NULL)
+	{
+		if (____findManifest(objectName) == -1)
+			return;
+		sprintf(record, "-%.50s", objectName);
+	}
+	else
+	{
+		sprintf(record, "%.50s\t%s\t%s\t%s\t%u\t%s", objectName,
+					____manifestString(objectData, length, "TYPE", type, sizeof(type)),
+					____manifestString(objectData, length, "GROUP", group, sizeof(group)),
+					____manifestString(objectData, length, "VERSION", version, sizeof(version)),
+					length,
+					____manifestString(objectData, length, "SIGN", sign, sizeof(sign)));
+
+		// Nothing to do if what the manifest is looked up by has not changed. The size alone is not worth a flash write:
+		// it changes every time the journal of a DATA or CONFIG object is compacted
+		if ((i = ____findManifest(objectName)) != -1 && strcmp(manifest[i].type, type) == 0 &&
+			strcmp(manifest[i].group, group) == 0 && strcmp(manifest[i].version, version) == 0 && strcmp(manifest[i].sign, sign) == 0)
+			return;
+	}
+
+	____appendManifest(record);
+	____applyManifest(record);
+
+	if (manifestDead > C_MANIFEST_MIN_DEAD && manifestDead > manifestCount)
+		____writeManifest();
+}
+
+// Move the manifest entry of a renamed file
+static void IRIS_RenameManifest(char * objectName, char * newName)
+{
+	int i;
+	char record[300];
+
+	____loadManifest();
+
+	if ((i = ____findManifest(objectName)) == -1)
+		return;
+
+	sprintf(record, "%.50s\t%.50s\t%.50s\t%.50s\t%u\t%.50s", newName, manifest[i].type, manifest[i].group, manifest[i].version, manifest[i].size, manifest[i].sign);
+	IRIS_UpdateManifest(objectName, NULL, 0);
+	____appendManifest(record);
+	____applyManifest(record);
+}
+
+//
+// Build the manifest object sent with a sync request: {TYPE:SYNC,OBJECTS:[[NAME,VERSION,SIGN],...]}
+// The SIGN is cut down to its first 8 characters. The terminal's own DATA and CONFIG objects are not included.
+// Elements of array containers are listed by object name rather than slot file name.
+//
+static char * ____syncObject(void)
+{
+	int i;
+	uint length;
+	char * object;
+
+	____loadManifest();
+
+	object = my_malloc(30 + manifestCount * (50 + 50 + 8 + 5));
+	strcpy(object, "{TYPE:SYNC,OBJECTS:[");
+	length = strlen(object);
+
+	for (i = 0; i < manifestCount; i++)
+	{
+		char objectName[100];
+
+		// Array container slots are reported under the object name of their current index
+		strcpy(objectName, manifest[i].record);
+		if (strchr(objectName, '#') && ____slotObjectName(manifest[i].record, objectName) == false)
+			continue;
+
+		if (strcmp(manifest[i].type, "DATA") == 0 || strncmp(manifest[i].type, "CONFIG", 6) == 0 ||
+			strpbrk(objectName, ",:[]{}") || strpbrk(manifest[i].version, ",:[]{}") || strpbrk(manifest[i].sign, ",:[]{}"))
+			continue;
+
+		length += sprintf(&object[length], "%s[%.50s,%.50s,%.8s]", object[length-1] == '['? "":",", objectName, manifest[i].version, manifest[i].sign);
+	}
+
+	strcpy(&object[length], "]}");
+
+	return object;
+}
+
+char * IRIS_GetTypeObjectData(uint count, uint * length, char * type)
 {
 	int i, j;
-	char fileName[50];
 	char * data;
-	char search[100];
+	uint myCount = count;
+
+	____loadManifest();
+
+	// As with the directory scan this replaces, look for the object on the F: drive first then on the I: drive counting again.
+	// The TYPE only has to start with the type asked for.
+	for (j = 0; count && j < 2; j++, count = myCount)
+	{
+		for (i = 0; i < manifestCount; i++)
+		{
+			char objectName[100];
+
+			if ((strncmp(manifest[i].record, "I:", 2) == 0) != (j == 1))
+				continue;
+
+			// Array container slots are recorded by file name. Their object name depends on the current index of the slot.
+			if (strchr(manifest[i].record, '#') && ____slotObjectName(manifest[i].record, objectName) == false)
+				continue;
+
+			if (strncmp(manifest[i].type, type, strlen(type)) == 0 && --count == 0)
+			{
+				// An object removed behind our back no longer belongs to the manifest
+				if ((data = IRIS_GetObjectData(strchr(manifest[i].record, '#')? objectName:manifest[i].record, length)) == NULL)
+				{
+					IRIS_UpdateManifest(manifest[i].record, NULL, 0);
+					count++, i--;
+					continue;
+				}
+
+				return data;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : Verified object ledger
+//
+// DESCRIPTION:	The ledger lists the size, date and SHA-1 of every object found
+//				authentic by ()OBJECTS_CHECK so the next check can skip the objects
+//				that have not changed since.
+//
+//				It is kept in the file __LEDGER.L as a "SIGN:xxx\n" line followed by
+//				records of "NAME\tSIZE\tDATE\tSHA-1\n". The SIGN value is calculated
+//				over the whole file the same way as an object signature so a ledger
+//				that was tampered with is ignored.
+//
+//-----------------------------------------------------------------------------
+//
+static void ____fileStamp(char * fileName, long * size, char * date)
+{
+#ifdef _DEBUG
+	FILE_HANDLE handle = open(fileName, FH_RDONLY);
+
+	*size = -1;
+	if (FH_OK(handle))
+	{
+		lseek(handle, 0, SEEK_END);
+		*size = ftell(handle);
+		close(handle);
+	}
+	date[0] = '\0';
+#else
+	*size = dir_get_file_sz(fileName);
+	if (dir_get_file_date(fileName, date) < 0)
+		date[0] = '\0';
+	date[14] = '\0';
+#endif
+}
+
+// Objects are checked in directory order which is also the ledger order so the next entry is looked at first
+static T_LEDGER * ____ledgerEntry(char * fileName, bool create)
+{
+	int i;
+
+	if (ledgerNext < ledgerCount && strcmp(ledger[ledgerNext].name, fileName) == 0)
+		return &ledger[ledgerNext++];
+
+	for (i = 0; i < ledgerCount; i++)
+	{
+		if (strcmp(ledger[i].name, fileName) == 0)
+		{
+			ledgerNext = i + 1;
+			return &ledger[i];
+		}
+	}
+
+	if (create == false || strlen(fileName) >= sizeof(ledger[0].name))
+		return NULL;
+
+	if (ledgerCount == ledgerMax)
+	{
+		ledgerMax += 32;
+		ledger = ledger? my_realloc(ledger, ledgerMax * sizeof(T_LEDGER)):my_malloc(ledgerMax * sizeof(T_LEDGER));
+	}
+
+	memset(&ledger[ledgerCount], 0, sizeof(T_LEDGER));
+	strcpy(ledger[ledgerCount].name, fileName);
+	return &ledger[ledgerCount++];
+}
+
+void IRIS_LedgerOpen(char * keySlot)
+{
+	char * data;
+	char * record;
+	char * next;
+	char * ptr;
+	uint size;
+	T_LEDGER * entry;
+	FILE_HANDLE handle;
+
+	ledgerCount = ledgerNext = 0;
+	ledgerChanged = false;
+	if (keySlot == NULL) return;
+
+	handle = open((char *) ledgerFile, FH_RDONLY);
+	if (FH_ERR(handle)) return;
+
+	size = lseek(handle, 0, SEEK_END);
+#ifdef _DEBUG
+	size = ftell(handle);
+#endif
+	lseek(handle, 0, SEEK_SET);
+
+	data = my_malloc(size + 1);
+	read(handle, data, size);
+	data[size] = '\0';
+	close(handle);
+
+	// Only a ledger with the correct SIGN value is taken
+	if (size > 46 && strncmp(data, "SIGN:", 5) == 0 && IRIS_VerifyObjectSignature(data, size, keySlot))
+	{
+		for (record = &data[46]; (next = strchr(record, '\n')) != NULL; record = next + 1)
+		{
+			*next = '\0';
+			if ((ptr = strchr(record, '\t')) == NULL) continue;
+			*ptr++ = '\0';
+
+			if ((entry = ____ledgerEntry(record, true)) != NULL)
+			{
+				entry->size = atol(ptr);
+				if ((ptr = strchr(ptr, '\t')) != NULL)
+				{
+					sprintf(entry->date, "%.14s", ++ptr);
+					if ((ptr = strchr(ptr, '\t')) != NULL && strlen(++ptr) == 40)
+						UtilStringToHex(ptr, 40, entry->hash);
+					else
+						entry->size = -1;		// Never matches
+					if ((ptr = strchr(entry->date, '\t')) != NULL)
+						*ptr = '\0';
+				}
+				else entry->size = -1;
+			}
+		}
+	}
+
+	my_free(data);
+	ledgerNext = 0;
+}
+
+bool IRIS_LedgerVerified(char * fileName, char * objectData, uint length)
+{
+	sha1_context sha1;
+	uchar hash[20];
+	long size;
+	char date[15];
+	T_LEDGER * entry = ____ledgerEntry(fileName, false);
+
+	if (entry == NULL || entry->size == -1)
+		return false;
+
+	// Without the object data, the object file must not have changed since it was verified
+	if (objectData == NULL)
+	{
+		____fileStamp(fileName, &size, date);
+		if (size != entry->size || strcmp(date, entry->date))
+			return false;
+	}
+
+	// With the object data, its content must be the same as when it was verified
+	else
+	{
+		sha1_starts(&sha1);
+		sha1_update(&sha1, (uchar *) objectData, length);
+		sha1_finish(&sha1, hash);
+		if (memcmp(hash, entry->hash, sizeof(hash)))
+			return false;
+	}
+
+	entry->current = true;
+	return true;
+}
+
+void IRIS_LedgerRecord(char * fileName, char * objectData, uint length)
+{
+	sha1_context sha1;
+	T_LEDGER old;
+	int count = ledgerCount;
+	T_LEDGER * entry = ____ledgerEntry(fileName, true);
+
+	if (entry == NULL) return;
+
+	old = *entry;
+	____fileStamp(fileName, &entry->size, entry->date);
+	sha1_starts(&sha1);
+	sha1_update(&sha1, (uchar *) objectData, length);
+	sha1_finish(&sha1, entry->hash);
+	entry->current = true;
+
+	if (ledgerCount != count || old.size != entry->size || strcmp(old.date, entry->date) || memcmp(old.hash, entry->hash, sizeof(old.hash)))
+		ledgerChanged = true;
+}
+
+void IRIS_LedgerClose(char * keySlot)
+{
+	int i;
+	uint length;
+	char * data;
+	char sign[41];
+	FILE_HANDLE handle;
+
+	// Entries not found current by this check are dropped
+	for (i = 0; i < ledgerCount; i++)
+	{
+		if (ledger[i].current == false)
+			ledgerChanged = true;
+	}
+
+	// Do not rewrite and sign the ledger again if it is still the same
+	if (ledgerChanged == false)
+	{
+		ledgerCount = ledgerNext = 0;
+		return;
+	}
+
+	data = my_malloc(47 + ledgerCount * (sizeof(ledger[0].name) + 12 + sizeof(ledger[0].date) + 40 + 3));
+	strcpy(data, "SIGN:0000000000000000000000000000000000000000\n");
+	length = strlen(data);
+
+	for (i = 0; i < ledgerCount; i++)
+	{
+		if (ledger[i].current == false) continue;
+
+		length += sprintf(&data[length], "%s\t%ld\t%s\t", ledger[i].name, ledger[i].size, ledger[i].date);
+		UtilHexToString(ledger[i].hash, sizeof(ledger[i].hash), &data[length]);
+		length += 40;
+		data[length++] = '\n';
+	}
+
+	// Only write a ledger we can sign
+	if (keySlot && ____sign(data, length, 5, keySlot, sign))
+	{
+		memcpy(&data[5], sign, 40);
+		handle = open((char *) ledgerFile, FH_NEW);
+		if (FH_OK(handle))
+		{
+			write(handle, data, length);
+			close(handle);
+		}
+	}
+
+	my_free(data);
+	ledgerCount = ledgerNext = 0;
+	ledgerChanged = false;
+}
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : IRIS_GetStringValue
+//
+// DESCRIPTION:	Look inside the object passed in 'data' for an string with the name
+//				'name' and return its data stored within an allocated memory block
+//				for easy parsing.
+////
+// PARAMETERS:	data	<=	The main object
+//				name	<=	The 'string' part of the object.
+//
+// RETURNS:		Pointer to an allocated memory structure representing the 'value'
+//				of the object in question.
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : ____parseStringValue
+//
+// DESCRIPTION:	Parse the value starting at position 'i' of the object passed in 'data'
+//				and return it within an allocated memory block for easy parsing.
+//
+// PARAMETERS:	data	<=	The main object
+//				size	<=	The size of the main object
+//				i		<=	Position of the value just after the ':' of its name
+//
+// RETURNS:		Pointer to an allocated memory structure representing the 'value'
+//
+//-----------------------------------------------------------------------------
+//
+static char * ____parseStringValue(char * data, int size, int i)
+{
+	uchar search[4000];
+	int j, k;
+	int length = 0;
+	int count[20];	// Assuming a maximum of 20 nested levels...I think this is more than enough
+	int level = 0;
+	char * value;
 	char * ptr;
-	uint myCount = count;
+	int valueStart;
+	int sqwigly;
+	int square = 0;
+
+	// Find amount of memory needed to store the value in a quickly accessible location
+	for (memset(count, 0, sizeof(count)), valueStart = i, sqwigly = 0, j = 0; i < size; i++)
+	{
+		// Treat inner objects as part of the element data and ignore arrays and commas within it (if sqwigly is set)...
+		// If we find the beginning of an array, store an indication and increment the level
+		if (sqwigly == 0 && (valueStart == i || data[i-1] == '[' || data[i-1] == ',') && data[i] == '[')
+		{
+			search[j++] = '[';
+			square++;
+			level++;
+		}
+
+		// If we find comma or closing bracket then capture the length of the current element
+		else if (sqwigly == 0 && (data[i] == ',' || (square && data[i] == ']')))
+		{
+			// Store the length of the element
+			search[j++] = (length+5) >> 8 | 0x80;	// Setting the top bit ensures we do not conflict with commas and brackets
+			search[j++] = ((length+5) & 0xFF);		// Adding FIVE to the length allows elements to be stored later as strings ending with a NULL,
+													// and also allows for the type of the element (4 bytes for allignment) to be stored in the beginning simplifying deallocation
+			length = 0;
+
+			// If a closing bracket///
+			if (data[i] == ']')
+			{
+				search[j++] = ']';
+				square--;
+				length = (count[level]+2) * sizeof(char *) - 1;	//Include the last element and an end of list null pointer.
+				count[level--] = 0;
+				if (level == 0)
+				{
+					// Store the length of the element
+					search[j++] = (length+5) >> 8 | 0x80;	// Setting the top bit ensures we do not conflict with commas and brackets
+					search[j++] = ((length+5) & 0xFF);		// Adding TWO to the length allows elements to be stored later as strings ending with a NULL,
+															// and also allows for the type of the element  (4 bytes for allignment) to be stored in the beginning simplifying deallocation
+					length = 0;
+				}
+			}
+
+			// else, make sure we capture the location of the comma
+			else if (data[i] == ',')
+			{
+				if (level == 0)
+				{
+					i--;
+					break;
+				}
+				count[level]++;
+				search[j++] = ',';
+			}
+
+			// If the level is ZERO, then this is the end of the entire object value
+			if (level == 0) break;
+		}
+
+		// If this is the end of the object, do not count it
+		// Otherwise, keep counting the length of the current element
+		else if (data[i] != '}' || sqwigly)
+		{
+			// Count down embedded objects as we find the closing sqwigly brackets
+			if (data[i] == '}') sqwigly--;
+			// If an internal object is detected, make sure we also count the closing sqwigly bracket
+			else if (data[i] == '{') sqwigly++;
+
+			length++;
+		}
+	}
+
+	// If the element is not an array, then just allocate a single buffer for the element
+	if (length)
+	{
+		i -= 2;									// Lose the NULL character at the end of the string and the } or , after the element value
+		search[j++] = (length+5) >> 8 | 0x80;	// Setting the top bit ensures we do not conflict with commas and brackets
+		search[j++] = ((length+5) & 0xFF);		// Adding FIVE to the length allows elements to be stored later as strings ending with a NULL,
+	}
+	else if (j == 0)
+	{
+		search[j++] = 0x80;
+		search[j++] = 0x05;
+	}
+
+	// Allocate memory for each array and element in the value list
+	for (memset(count, 0, sizeof(count)), level = 0, --j; j >= 0; j--)
+	{
+		if ((j > 0 && (search[j-1] & 0x80)) &&
+			(j < 2 || (search[j-2] & 0x80) == 0))
+		{
+			count[level] = (search[j-1] & 0x7F) * 256 + search[j--];
+			if (level == 0)
+				ptr = value = my_calloc(count[level] < 5? 5:count[level]);	// This also ensures it is all initialised properl. Important if we need a NULL pointer at the end.
+			else
+			{
+				for (k = 0, ptr = (char *) &value; k < level; k++)
+				{
+					ptr = *((char **) ptr);
+					ptr[0] = 1;	// This indicates that this is an array
+					ptr = &ptr[count[k]-8];
+				}
+				*((char **) ptr) = my_calloc(count[level]);
+				ptr = *((char **) ptr);
+			}
+		}
+		else if (search[j] == ']' && data[i] == ']')
+		{
+			level++;
+			i--;
+		}
+		else if (search[j] == '[' || search[j] == ',')
+		{
+			if (data[i] != ',' || data[i+1] != '[' || data[i] != search[j])
+			{
+				for (sqwigly = 0;sqwigly || data[i] != search[j]; i--, count[level]--)
+				{
+					if (data[i] == '}') sqwigly++;
+					else if (data[i] == '{') sqwigly--;
+					ptr[count[level]-2] = data[i];
+				}
+				if (search[j] == '[')
+					--level;
+				if (level > 0) count[level-1] -= sizeof(char *);
+			}
+			i--;
+		}
+	}
+
+	// If the element is not an array, then just store the value
+	for (;i >= valueStart; i--, count[level]--)
+		ptr[count[level]-2] = data[i];
+	
+	// Return the value data pointer
+	return value;
+}
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : ____indexTags
+//
+// DESCRIPTION:	Build an index of the top level tags of an object so string values can
+//				be located without rescanning the object from the beginning.
+//
+//				The scan follows the exact rules used by IRIS_GetStringValue() to locate
+//				a tag so both always agree on what is found and in which position.
+//
+// PARAMETERS:	data	<=	The main object
+//				size	<=	The size of the main object
+//
+// RETURNS:		An allocated tag index
+//
+//-----------------------------------------------------------------------------
+//
+//
+// Locate the top level tag at the separator "*position" points to ('{' for the first tag)
+// and move "*position" on to the separator of the next tag.
+//
+static bool ____nextTag(char * data, int size, int * position, T_TAG * tag)
+{
+	int i = *position;
+	int k;
+	int sqwigly, square;
+
+	// The object must start with a sqwigly bracket and tags are separated by commas
+	if (i >= size || data[i] != ((i == 0)? '{':','))
+		return false;
+
+	for (k = 0; (i+k+1) < size && data[i+k+1] != ':' && data[i+k+1] != ',' && data[i+k+1] != '}' && k < 255; k++);
+
+	tag->name = i+1;
+	tag->nameLength = k;
+	tag->value = ((i+k+1) < size && data[i+k+1] == ':')? (i+k+2):0;
+	tag->tree = NULL;
+
+	// Skip to the next top level separator or the end of the object
+	for (i++, sqwigly = 0, square = 0; i < size; i++)
+	{
+		if (data[i] == '[')
+			square++;
+		else if (data[i] == ']')
+			square--;
+		else if (square == 0)
+		{
+			if (data[i] == '{')
+				sqwigly++;
+			else if (data[i] == '}')
+			{
+				if (--sqwigly < 0)
+					break;
+			}
+			else if (sqwigly == 0 && data[i] == ',')
+				break;
+		}
+	}
+
+	*position = i;
+	return true;
+}
+
+static T_TAG_INDEX * ____indexTags(char * data, int size)
+{
+	int i;
+	int position = 0;
+	int max = 0;
+	T_TAG tag;
+	T_TAG_INDEX * index = my_calloc(sizeof(T_TAG_INDEX));
+
+	while (____nextTag(data, size, &position, &tag))
+	{
+		if (index->count == max)
+		{
+			max += 32;
+			index->tag = index->tag? my_realloc(index->tag, max * sizeof(T_TAG)):my_malloc(max * sizeof(T_TAG));
+		}
+		index->tag[index->count++] = tag;
+	}
+
+	// Hash the tag names. Only the first occurrence of a name is reachable by name, as with a scan.
+	for (index->slots = 8; index->slots < index->count * 2; index->slots *= 2);
+	index->slot = my_calloc(index->slots * sizeof(uint));
+
+	for (i = 0; i < index->count; i++)
+	{
+		T_TAG * tag = &index->tag[i];
+		uint slot;
+
+		if (tag->value == 0) continue;
+
+		for (slot = ____hash(&data[tag->name], tag->nameLength) & (index->slots - 1); index->slot[slot]; slot = (slot + 1) & (index->slots - 1))
+		{
+			T_TAG * other = &index->tag[index->slot[slot]-1];
+			if (other->nameLength == tag->nameLength && memcmp(&data[other->name], &data[tag->name], tag->nameLength) == 0)
+				break;
+		}
+
+		if (index->slot[slot] == 0)
+			index->slot[slot] = i + 1;
+	}
+
+	return index;
+}
+
+static void ____freeTagIndex(T_TAG_INDEX * index)
+{
+	int i;
+
+	if (index == NULL) return;
+
+	for (i = 0; i < index->count; i++)
+		IRIS_DeallocateStringValue(index->tag[i].tree);
+
+	if (index->tag) my_free(index->tag);
+	if (index->slot) my_free(index->slot);
+	my_free(index);
+}
 
-	// Prepare the type search buffer
-	sprintf(search, "TYPE:%s", type);
+static T_TAG * ____findTag(T_TAG_INDEX * index, char * data, char * name)
+{
+	int length = strlen(name);
+	uint slot;
 
-	for (j = 0; count && j < 2; j++, count = myCount)
+	for (slot = ____hash(name, length) & (index->slots - 1); index->slot[slot]; slot = (slot + 1) & (index->slots - 1))
+	{
+		T_TAG * tag = &index->tag[index->slot[slot]-1];
+		if (tag->nameLength == length && memcmp(&data[tag->name], name, length) == 0)
+			return tag;
+	}
+
+	return NULL;
+}
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : ____getIndexedStringValue
+//
+// DESCRIPTION:	Same as IRIS_GetStringValue() but using a tag index of the object
+//
+// PARAMETERS:	data	<=	The main object
+//				size	<=	The size of the main object
+//				index	<=	The tag index of the main object
+//				name	<=	The 'string' part of the object or its position.
+//							If a position, it is updated with the string name.
+//
+// RETURNS:		Pointer to an allocated memory structure representing the 'value'
+//				of the object in question.
+//
+//-----------------------------------------------------------------------------
+//
+static char * ____getIndexedStringValue(char * data, int size, T_TAG_INDEX * index, char * name)
+{
+	T_TAG * tag = NULL;
+
+	// If this is a position search, then get the tag at that position
+	if (name[0] >= '0' && name[0] <= '9')
 	{
-		strcpy(fileName, j?"I:":"F:");
-		for (i = dir_get_first(fileName); i == 0; i = dir_get_next(fileName))
+		int position = atol(name);
+
+		if (position < index->count)
 		{
-			if ((data = IRIS_GetObjectData(fileName, length)) != NULL)
-			{
-				if (data[0] == '{' && data[*length-1] == '}' && (ptr = strstr(data, search)) != NULL && (ptr[-1] == ',' || ptr[-1] == '{'))
-				{
-					if (--count == 0) return data;
-				}
-			}
+			int k;
 
-			my_free(data);
+			tag = &index->tag[position];
+			for (k = 0; k < tag->nameLength && k < 64; k++)
+				name[k] = data[tag->name+k];
+			name[k] = '\0';
 		}
 	}
 
+	// Otherwise, look the name up
+	else tag = ____findTag(index, data, name);
+
+	if (tag == NULL || tag->value == 0 || tag->value >= (uint) size)
+		return NULL;
+
+	return ____parseStringValue(data, size, tag->value);
+}
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : IRIS_NextStringValue
+//
+// DESCRIPTION:	Iterates over the top level string:value pairs of an object in order
+//				in a single forward pass. Strings without a value are skipped.
+//
+// PARAMETERS:	data		<=	The main object
+//				size		<=	The size of the main object
+//				position	<=>	Set to 0 before the first call. Updated to carry on from there.
+//				name		=>	The string name
+//				nameSize	<=	The size of the name buffer
+//
+// RETURNS:		Pointer to an allocated memory structure representing the 'value'
+//				of the string or NULL if there are no more.
+//
+//-----------------------------------------------------------------------------
+//
+char * IRIS_NextStringValue(char * data, int size, int * position, char * name, int nameSize)
+{
+	T_TAG tag;
+
+	while (____nextTag(data, size, position, &tag))
+	{
+		int k;
+
+		if (tag.value == 0 || tag.value >= (uint) size)
+			continue;
+
+		for (k = 0; k < tag.nameLength && k < (nameSize-1); k++)
+			name[k] = data[tag.name+k];
+		name[k] = '\0';
+
+		return ____parseStringValue(data, size, tag.value);
+	}
 
 	return NULL;
 }
 
 //
 //-----------------------------------------------------------------------------
-// FUNCTION   : IRIS_GetStringValue
+// FUNCTION   : ____objectTagIndex
+//
+// DESCRIPTION:	If the object data is held by the object cache, return its tag index
+//				building it on the first request
 //
-// DESCRIPTION:	Look inside the object passed in 'data' for an string with the name
-//				'name' and return its data stored within an allocated memory block
-//				for easy parsing.
-////
 // PARAMETERS:	data	<=	The main object
-//				name	<=	The 'string' part of the object.
+//				size	<=	The size of the main object
 //
-// RETURNS:		Pointer to an allocated memory structure representing the 'value'
-//				of the object in question.
+// RETURNS:		The tag index or NULL if the object data is not cached
+//
+//-----------------------------------------------------------------------------
+//
+static T_TAG_INDEX * ____objectTagIndex(char * data, int size)
+{
+	int i;
+
+	for (i = 0; i < C_OBJECT_CACHE_ENTRIES; i++)
+	{
+		if (objectCache[i].data == data && objectCache[i].length == (uint) size)
+		{
+			if (objectCache[i].index == NULL)
+				objectCache[i].index = ____indexTags(data, size);
+			return objectCache[i].index;
+		}
+	}
+
+	return NULL;
+}
+
 //
 //-----------------------------------------------------------------------------
 //
 char * IRIS_GetStringValue(char * data, int size, char * name, bool partial)
 {
-	uchar search[4000];
-	int i, j, k;
-	int length = 0;
-	int count[20];	// Assuming a maximum of 20 nested levels...I think this is more than enough
-	int level = 0;
-	char * value;
-	char * ptr;
-	int valueStart;
+	int i, k;
 	int sqwigly;
 	int square;
 	int position = -1000;
+	T_TAG_INDEX * index;
+
+	// Use the tag index if this is a cached object. The index only holds whole tag names up to 255 characters so
+	// partial names and longer names are still found by scanning
+	if ((name[0] >= '0' && name[0] <= '9') || (partial == false && strlen(name) < 255))
+	{
+		if ((index = ____objectTagIndex(data, size)) != NULL)
+			return ____getIndexedStringValue(data, size, index, name);
+	}
 
 	// If this is a position search, then find the required position
 	if (name[0] >= '0' && name[0] <= '9')
@@ -964,136 +3502,81 @@ char * IRIS_GetStringValue(char * data, int size, char * name, bool partial)
 	if (i == size)
 		return NULL;
 
-	// Find amount of memory needed to store the value in a quickly accessible location
-	for (memset(count, 0, sizeof(count)), valueStart = i, sqwigly = 0, j = 0; i < size; i++)
-	{
-		// Treat inner objects as part of the element data and ignore arrays and commas within it (if sqwigly is set)...
-		// If we find the beginning of an array, store an indication and increment the level
-		if (sqwigly == 0 && (valueStart == i || data[i-1] == '[' || data[i-1] == ',') && data[i] == '[')
-		{
-			search[j++] = '[';
-			square++;
-			level++;
-		}
-
-		// If we find comma or closing bracket then capture the length of the current element
-		else if (sqwigly == 0 && (data[i] == ',' || (square && data[i] == ']')))
-		{
-			// Store the length of the element
-			search[j++] = (length+5) >> 8 | 0x80;	// Setting the top bit ensures we do not conflict with commas and brackets
-			search[j++] = ((length+5) & 0xFF);		// Adding FIVE to the length allows elements to be stored later as strings ending with a NULL,
-													// and also allows for the type of the element (4 bytes for allignment) to be stored in the beginning simplifying deallocation
-			length = 0;
-
-			// If a closing bracket///
-			if (data[i] == ']')
-			{
-				search[j++] = ']';
-				square--;
-				length = (count[level]+2) * sizeof(char *) - 1;	//Include the last element and an end of list null pointer.
-				count[level--] = 0;
-				if (level == 0)
-				{
-					// Store the length of the element
-					search[j++] = (length+5) >> 8 | 0x80;	// Setting the top bit ensures we do not conflict with commas and brackets
-					search[j++] = ((length+5) & 0xFF);		// Adding TWO to the length allows elements to be stored later as strings ending with a NULL,
-															// and also allows for the type of the element  (4 bytes for allignment) to be stored in the beginning simplifying deallocation
-					length = 0;
-				}
-			}
-
-			// else, make sure we capture the location of the comma
-			else if (data[i] == ',')
-			{
-				if (level == 0)
-				{
-					i--;
-					break;
-				}
-				count[level]++;
-				search[j++] = ',';
-			}
+	return ____parseStringValue(data, size, i);
+}
 
-			// If the level is ZERO, then this is the end of the entire object value
-			if (level == 0) break;
-		}
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : IRIS_GetParsedStringValue
+//
+// DESCRIPTION:	Same as IRIS_GetStringValue() but if the object data is cached, the parsed
+//				value is kept with the cached object when released so entering the same
+//				object again does not need to parse the value again. The function table
+//				positions resolved while evaluating the value are kept with it as well.
+//
+//				The value is for the exclusive use of the caller until it is released by
+//				IRIS_ReleaseStringValue(). It may be modified (eg. display loop counters)
+//				but its structure must remain the same.
+//
+// PARAMETERS:	data	<=	The main object
+//				size	<=	The size of the main object
+//				name	<=	The 'string' part of the object
+//
+// RETURNS:		Pointer to an allocated memory structure representing the 'value'
+//				of the object in question.
+//
+//-----------------------------------------------------------------------------
+//
+char * IRIS_GetParsedStringValue(char * data, int size, char * name)
+{
+	T_TAG_INDEX * index;
+	T_TAG * tag;
+	char * value;
 
-		// If this is the end of the object, do not count it
-		// Otherwise, keep counting the length of the current element
-		else if (data[i] != '}' || sqwigly)
-		{
-			// Count down embedded objects as we find the closing sqwigly brackets
-			if (data[i] == '}') sqwigly--;
-			// If an internal object is detected, make sure we also count the closing sqwigly bracket
-			else if (data[i] == '{') sqwigly++;
+	if ((index = ____objectTagIndex(data, size)) == NULL)
+		return IRIS_GetStringValue(data, size, name, false);
 
-			length++;
-		}
-	}
+	if ((tag = ____findTag(index, data, name)) == NULL || tag->value == 0 || tag->value >= (uint) size)
+		return NULL;
 
-	// If the element is not an array, then just allocate a single buffer for the element
-	if (length)
-	{
-		i -= 2;									// Lose the NULL character at the end of the string and the } or , after the element value
-		search[j++] = (length+5) >> 8 | 0x80;	// Setting the top bit ensures we do not conflict with commas and brackets
-		search[j++] = ((length+5) & 0xFF);		// Adding FIVE to the length allows elements to be stored later as strings ending with a NULL,
-	}
-	else if (j == 0)
+	// Take the kept value if available. If the same object is being displayed at a deeper callback level, it will be parsed again.
+	if (tag->tree)
 	{
-		search[j++] = 0x80;
-		search[j++] = 0x05;
+		value = tag->tree;
+		tag->tree = NULL;
+		return value;
 	}
 
-	// Allocate memory for each array and element in the value list
-	for (memset(count, 0, sizeof(count)), level = 0, --j; j >= 0; j--)
-	{
-		if ((j > 0 && (search[j-1] & 0x80)) &&
-			(j < 2 || (search[j-2] & 0x80) == 0))
-		{
-			count[level] = (search[j-1] & 0x7F) * 256 + search[j--];
-			if (level == 0)
-				ptr = value = my_calloc(count[level] < 5? 5:count[level]);	// This also ensures it is all initialised properl. Important if we need a NULL pointer at the end.
-			else
-			{
-				for (k = 0, ptr = (char *) &value; k < level; k++)
-				{
-					ptr = *((char **) ptr);
-					ptr[0] = 1;	// This indicates that this is an array
-					ptr = &ptr[count[k]-8];
-				}
-				*((char **) ptr) = my_calloc(count[level]);
-				ptr = *((char **) ptr);
-			}
-		}
-		else if (search[j] == ']' && data[i] == ']')
-		{
-			level++;
-			i--;
-		}
-		else if (search[j] == '[' || search[j] == ',')
-		{
-			if (data[i] != ',' || data[i+1] != '[' || data[i] != search[j])
-			{
-				for (sqwigly = 0;sqwigly || data[i] != search[j]; i--, count[level]--)
-				{
-					if (data[i] == '}') sqwigly++;
-					else if (data[i] == '{') sqwigly--;
-					ptr[count[level]-2] = data[i];
-				}
-				if (search[j] == '[')
-					--level;
-				if (level > 0) count[level-1] -= sizeof(char *);
-			}
-			i--;
-		}
-	}
+	return ____parseStringValue(data, size, tag->value);
+}
 
-	// If the element is not an array, then just store the value
-	for (;i >= valueStart; i--, count[level]--)
-		ptr[count[level]-2] = data[i];
-	
-	// Return the value data pointer
-	return value;
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : IRIS_ReleaseStringValue
+//
+// DESCRIPTION:	Return a value obtained by IRIS_GetParsedStringValue() to the cached object.
+//				If the object is no longer cached, the value is deallocated.
+//
+// PARAMETERS:	data	<=	The main object
+//				size	<=	The size of the main object
+//				name	<=	The 'string' part of the object
+//				value	<=	The value obtained by IRIS_GetParsedStringValue()
+//
+// RETURNS:		None
+//
+//-----------------------------------------------------------------------------
+//
+void IRIS_ReleaseStringValue(char * data, int size, char * name, char * value)
+{
+	T_TAG_INDEX * index;
+	T_TAG * tag;
+
+	if (value == NULL) return;
+
+	if ((index = ____objectTagIndex(data, size)) != NULL && (tag = ____findTag(index, data, name)) != NULL && tag->tree == NULL)
+		tag->tree = value;
+	else
+		IRIS_DeallocateStringValue(value);
 }
 
 //
@@ -1134,12 +3617,43 @@ void IRIS_DeallocateStringValue(char * value)
 		for (i = 4; *((char **) &value[i]) != NULL; i += sizeof(char *))
 			IRIS_DeallocateStringValue(*((char **) &value[i]));
 
-		// Deallocate the array itself
-		my_free(value);
+		// Deallocate the array itself
+		my_free(value);
+	}
+}
+
+
+//
+// Push a prepared stack slot. Any number, pointer or length must be set in the slot beforehand
+// as a function may be executed and consume the slot before returning.
+//
+static void ____stackPush(uchar type, char * value)
+{
+	int i;
+
+	stack[++stackIndex].type = type;
+	stack[stackIndex].value = value;
+	stack[stackIndex].level = stackLevel;
+	if (!value || value[0] != '(' || value[1] != ')') stack[stackIndex].func = 255;
+
+	// Look for a function at the same level and resolve its value if available
+	for (i = stackIndex; i >= 0 && stack[i].level == stackLevel; i--)
+	{
+		if (stack[i].func != 255)
+		{
+			if (irisFunc[stack[i].func].paramCount == (stackIndex-i))
+			{
+				uchar prevFunc = currentFunc;
+
+				currentFunc = stack[i].func;
+				irisFunc[stack[i].func].funcPtr();
+				currentFunc = prevFunc;
+			}
+			break;
+		}
 	}
 }
 
-
 //
 //-------------------------------------------------------------------------------------------
 // FUNCTION   : IRIS_StackPush
@@ -1156,46 +3670,164 @@ void IRIS_DeallocateStringValue(char * value)
 //
 void IRIS_StackPush(char * value)
 {
-	int i;
+	char * copy = NULL;
 
 	if (stack == NULL) return;
-	
-	UtilStrDup(&stack[++stackIndex].value, value);
-	stack[stackIndex].level = stackLevel;
-	if (!value || value[0] != '(' || value[1] != ')') stack[stackIndex].func = 255;
 
-	// Look for a function at the same level and resolve its value if available
-	for (i = stackIndex; i >= 0 && stack[i].level == stackLevel; i--)
+	UtilStrDup(&copy, value);
+	____stackPush(C_STACK_STRING, copy);
+}
+
+//
+//-------------------------------------------------------------------------------------------
+// FUNCTION   : IRIS_StackPushConst, IRIS_StackPushNumber, IRIS_StackPushBlob, IRIS_StackPushBlobConst,
+//				IRIS_StackPushAllocatedBlob, IRIS_StackPushPointer
+//
+// DESCRIPTION:	Same as IRIS_StackPush() without copying the value into a new string.
+//				A constant string is borrowed and must outlive the stack slot.
+//				A number, blob or pointer is only turned into text if IRIS_StackGet() asks for it.
+//				A blob may hold any byte including '\0'. As text, it is the ASCII hex of its bytes.
+//				IRIS_StackPushBlob() copies the bytes. IRIS_StackPushBlobConst() borrows them like
+//				a constant. IRIS_StackPushAllocatedBlob() hands a buffer from my_malloc() over to
+//				the stack. Either way the bytes must be followed by a '\0'.
+//
+// PARAMETERS:	value	<=	The value
+//				length	<=	The blob length
+//
+// RETURNS:		None
+//-------------------------------------------------------------------------------------------
+//
+void IRIS_StackPushConst(const char * value)
+{
+	if (stack == NULL) return;
+
+	____stackPush(C_STACK_CONST, (char *) value);
+}
+
+void IRIS_StackPushNumber(long value)
+{
+	if (stack == NULL) return;
+
+	stack[stackIndex+1].number = value;
+	____stackPush(C_STACK_NUMBER, NULL);
+}
+
+void IRIS_StackPushBlob(char * value, uint length)
+{
+	char * copy;
+
+	if (stack == NULL) return;
+
+	if (value == NULL)
 	{
-		if (stack[i].func != 255)
-		{
-			if (irisFunc[stack[i].func].paramCount == (stackIndex-i))
-				irisFunc[stack[i].func].funcPtr();
-			break;
-		}
+		____stackPush(C_STACK_STRING, NULL);
+		return;
 	}
+
+	copy = my_malloc(length + 1);
+	memcpy(copy, value, length);
+	copy[length] = '\0';
+	stack[stackIndex+1].pointer = copy;
+	stack[stackIndex+1].length = length;
+	____stackPush(C_STACK_BLOB, NULL);
 }
 
-bool IRIS_StackPushFunc(char * function)
+void IRIS_StackPushBlobConst(char * value, uint length)
 {
-	int i;
+	if (stack == NULL) return;
 
-	if (stack == NULL) return false;
-	
-	for (i = 0; i < C_NO_OF_IRIS_FUNCTIONS; i++)
+	if (value == NULL)
+	{
+		____stackPush(C_STACK_STRING, NULL);
+		return;
+	}
+
+	stack[stackIndex+1].pointer = value;
+	stack[stackIndex+1].length = length;
+	stack[stackIndex+1].borrowed = true;
+	____stackPush(C_STACK_BLOB, NULL);
+}
+
+void IRIS_StackPushAllocatedBlob(char * value, uint length)
+{
+	if (stack == NULL || value == NULL)
+	{
+		if (value) my_free(value);
+		IRIS_StackPushBlob(NULL, 0);
+		return;
+	}
+
+	stack[stackIndex+1].pointer = value;
+	stack[stackIndex+1].length = length;
+	____stackPush(C_STACK_BLOB, NULL);
+}
+
+void IRIS_StackPushPointer(void * value)
+{
+	if (stack == NULL) return;
+
+	stack[stackIndex+1].pointer = value;
+	____stackPush(C_STACK_POINTER, NULL);
+}
+
+static uint ____funcHash(char * function)
+{
+	// All function names start with "()" so leave that out
+	return ____hash(&function[2], strlen(&function[2])) & (C_FUNC_HASH_SLOTS - 1);
+}
+
+static int ____findFunc(char * function)
+{
+	uint i;
+
+	// Build the function name hash table the first time around
+	if (funcHash[____funcHash(irisFunc[0].name)] == 0)
 	{
-		if (strcmp(irisFunc[i].name, function) == 0)
+		for (i = 0; i < C_NO_OF_IRIS_FUNCTIONS && irisFunc[i].name; i++)
 		{
-			if (irisFunc[i].paramCount && irisFunc[i].array)
-				arrayOfArraysFlag = true;
+			uint j;
 
-			stack[stackIndex+1].func = i;
-			IRIS_StackPush(function);
-			return true;
+			for (j = ____funcHash(irisFunc[i].name); funcHash[j]; j = (j + 1) & (C_FUNC_HASH_SLOTS - 1));
+			funcHash[j] = i + 1;
 		}
 	}
 
-	return false;
+	for (i = ____funcHash(function); funcHash[i]; i = (i + 1) & (C_FUNC_HASH_SLOTS - 1))
+	{
+		if (strcmp(irisFunc[funcHash[i]-1].name, function) == 0)
+			return funcHash[i] - 1;
+	}
+
+	return -1;
+}
+
+static void ____stackPushFunc(int i)
+{
+	if (irisFunc[i].paramCount && irisFunc[i].array)
+		arrayOfArraysFlag = true;
+
+	// A function that may return something else with the same parameters makes the value change on its own
+	if (dependency && !irisFunc[i].stable)
+		dependency->changing = true;
+
+	stack[stackIndex+1].func = i;
+	____stackPush(C_STACK_CONST, irisFunc[i].name);
+}
+
+bool IRIS_StackPushFunc(char * function)
+{
+	int i;
+
+	if (stack == NULL || (i = ____findFunc(function)) == -1)
+		return false;
+
+	____stackPushFunc(i);
+	return true;
+}
+
+uchar IRIS_FuncOp(void)
+{
+	return (currentFunc == 255)? 0:irisFunc[currentFunc].op;
 }
 
 
@@ -1216,8 +3848,13 @@ void IRIS_StackPop(int count)
 	{
 		if (stackIndex >= 0)
 		{
-			if (stack[stackIndex].value)
-				UtilStrDup(&stack[stackIndex].value, NULL);
+			if (stack[stackIndex].value && stack[stackIndex].type != C_STACK_CONST && !stack[stackIndex].constText)
+				my_free(stack[stackIndex].value);
+			if (stack[stackIndex].type == C_STACK_BLOB && !stack[stackIndex].borrowed)
+				my_free(stack[stackIndex].pointer);
+			stack[stackIndex].value = NULL;
+			stack[stackIndex].borrowed = false;
+			stack[stackIndex].constText = false;
 			stackIndex--;
 		}
 	}
@@ -1234,13 +3871,103 @@ void IRIS_StackPop(int count)
 // RETURNS:		The value
 //-------------------------------------------------------------------------------------------
 //
+static char * ____stackText(T_STACK * slot)
+{
+	// Numbers, blobs and pointers only get their text when someone asks for it
+	if (slot->value == NULL)
+	{
+		char temp[20];
+
+		if (slot->type == C_STACK_NUMBER)
+			UtilStrDup(&slot->value, ltoa(slot->number, temp, 10));
+		else if (slot->type == C_STACK_BLOB)
+			slot->value = UtilHexToString(slot->pointer, slot->length, my_malloc(slot->length * 2 + 1));
+		else if (slot->type == C_STACK_POINTER && slot->pointer)
+		{
+			sprintf(temp, "%ld", (long) slot->pointer);
+			UtilStrDup(&slot->value, temp);
+		}
+	}
+
+	return slot->value;
+}
+
 char * IRIS_StackGet(char offset)
 {
 	if (stack && stackIndex >= offset)
-		return stack[stackIndex-offset].value;
+		return ____stackText(&stack[stackIndex-offset]);
+	return NULL;
+}
+
+//
+//-------------------------------------------------------------------------------------------
+// FUNCTION   : IRIS_StackGetNumber, IRIS_StackGetBytes, IRIS_StackGetPointer
+//
+// DESCRIPTION:	Read a value from the stack without converting it to text and back.
+//				A text value asked for as bytes is taken as ASCII hex. The bytes are decoded
+//				into a new buffer kept by the slot so it is only converted once. The slot
+//				keeps its text so IRIS_StackGet() still returns it as it was given.
+//
+// PARAMETERS:	offset	<=	How deep in the stack should we go from the top.
+//				length	=>	The number of bytes
+//
+// RETURNS:		The number (0 if not available), the bytes or the array of arrays handle.
+//				The bytes are followed by a '\0' and belong to the stack slot.
+//				The handle is NULL if the value was not pushed as a handle.
+//-------------------------------------------------------------------------------------------
+//
+long IRIS_StackGetNumber(char offset)
+{
+	char * value;
+
+	if (stack == NULL || stackIndex < offset)
+		return 0;
+
+	if (stack[stackIndex-offset].type == C_STACK_NUMBER)
+		return stack[stackIndex-offset].number;
+
+	return (value = ____stackText(&stack[stackIndex-offset])) != NULL? atol(value):0;
+}
+
+char * IRIS_StackGetBytes(char offset, uint * length)
+{
+	T_STACK * slot;
+	char * value;
+
+	*length = 0;
+	if (stack == NULL || stackIndex < offset)
+		return NULL;
+
+	slot = &stack[stackIndex-offset];
+	if (slot->type != C_STACK_BLOB)
+	{
+		if ((value = ____stackText(slot)) == NULL)
+			return NULL;
+
+		// The text is kept as it was given so it reads back the same
+		slot->pointer = my_calloc(strlen(value) / 2 + 2);
+		slot->length = UtilStringToHex(value, strlen(value), slot->pointer);
+		if (slot->type == C_STACK_CONST)
+			slot->constText = true;
+		slot->type = C_STACK_BLOB;
+	}
+
+	*length = slot->length;
+	return slot->pointer;
+}
+
+void * IRIS_StackGetPointer(char offset)
+{
+	if (stack && stackIndex >= offset && stack[stackIndex-offset].type == C_STACK_POINTER)
+		return stack[stackIndex-offset].pointer;
 	return NULL;
 }
 
+static bool ____stackIsBlob(char offset)
+{
+	return (bool) (stack && stackIndex >= offset && stack[stackIndex-offset].type == C_STACK_BLOB);
+}
+
 //
 //-------------------------------------------------------------------------------------------
 // FUNCTION   : IRIS_StackFlush
@@ -1257,7 +3984,10 @@ void IRIS_StackFlush(void)
 	int i;
 
 	for (i = 0; stack && i < (stackIndex+1); i++)
-		if (stack[i].value) my_free(stack[i].value);
+	{
+		if (stack[i].value && stack[i].type != C_STACK_CONST && !stack[i].constText) my_free(stack[i].value);
+		if (stack[i].type == C_STACK_BLOB && !stack[i].borrowed) my_free(stack[i].pointer);
+	}
 
 	if (stack) my_free(stack);
 	stack = NULL;
@@ -1351,8 +4081,279 @@ static void ____getSubString(char * rsimple, char * simpler)
 		}
 	}
 
-	// Get the stripped resolvable simple value
-	sprintf(simpler, "%.*s", i, rsimple);
+	// Get the stripped resolvable simple value
+	sprintf(simpler, "%.*s", i, rsimple);
+}
+
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : Temporary data store
+//
+// DESCRIPTION:	Temporary data is kept in an open addressing hash table keyed by the full
+//				name. Each entry holds its name, value and group in a single allocation and
+//				is also chained within a bucket of its object (the first component of the
+//				name) so all the temporary data of an object is found without a full scan.
+//				The table grows as needed up to the limit set by #MAXTEMPDATA in CONFIG.SYS
+//				or C_MAX_TEMP_DATA if not set.
+//
+//-----------------------------------------------------------------------------
+//
+static T_TEMPDATA ** ____tempObjectBucket(char * name)
+{
+	char * end = strchr(name, '/');
+
+	return &tempObject[____hash(name, end? (end - name):strlen(name)) & (C_TEMP_OBJECT_BUCKETS - 1)];
+}
+
+static int ____tempFind(char * name, uint hash)
+{
+	uint i;
+
+	if (tempDataSlots == 0)
+		return -1;
+
+	for (i = hash & (tempDataSlots - 1); tempData[i]; i = (i + 1) & (tempDataSlots - 1))
+	{
+		if (tempData[i]->hash == hash && strcmp(tempData[i]->name, name) == 0)
+			return i;
+	}
+
+	return -1;
+}
+
+static T_TEMPDATA * ____tempData(char * name)
+{
+	int i = ____tempFind(name, ____hash(name, strlen(name)));
+
+	return (i == -1)? NULL:tempData[i];
+}
+
+static T_TEMPDATA * ____tempPrefix(char * name)
+{
+	uint i;
+	int length = strlen(name);
+	T_TEMPDATA * entry;
+
+	// If the object part of the name is complete, only its own bucket needs looking at
+	if (name[0] && strchr(&name[1], '/'))
+	{
+		for (entry = *____tempObjectBucket(&name[1]); entry; entry = entry->next)
+		{
+			if (strncmp(entry->name, name, length) == 0)
+				return entry;
+		}
+		return NULL;
+	}
+
+	for (i = 0; i < tempDataSlots; i++)
+	{
+		if (tempData[i] && strncmp(tempData[i]->name, name, length) == 0)
+			return tempData[i];
+	}
+
+	return NULL;
+}
+
+static T_TEMPDATA * ____tempEntry(char * name, uint hash, char * value, int length, char * group)
+{
+	int nameLength = strlen(name) + 1;
+	int valueLength = ((length < 0)? strlen(value):length) + 1;
+	T_TEMPDATA * entry;
+
+	if (!group) group = "";
+	entry = my_malloc(sizeof(T_TEMPDATA) + nameLength + valueLength + strlen(group) + 1);
+
+	entry->name = (char *) &entry[1];
+	entry->value = entry->name + nameLength;
+	entry->group = entry->value + valueLength;
+	memcpy(entry->name, name, nameLength);
+	memcpy(entry->value, value, valueLength - 1);
+	entry->value[valueLength - 1] = '\0';
+	strcpy(entry->group, group);
+	entry->flag = (length < 0)? 0:C_TEMP_BYTES;
+	entry->length = valueLength - 1;
+	entry->hash = hash;
+
+	return entry;
+}
+
+static bool ____tempInsert(T_TEMPDATA * entry)
+{
+	uint i;
+	T_TEMPDATA ** bucket;
+
+	// Get the configured limit the first time around
+	if (tempDataLimit == 0)
+	{
+		char limit[12];
+		int length;
+
+		if ((length = get_env("#MAXTEMPDATA", limit, sizeof(limit)-1)) > 0)
+		{
+			limit[length] = '\0';
+			tempDataLimit = atol(limit);
+		}
+		if (tempDataLimit == 0)
+			tempDataLimit = C_MAX_TEMP_DATA;
+	}
+
+	// If the data area is full....
+	if ((uint) max_temp_data >= tempDataLimit)
+		return false;
+
+	// Grow the table when it is half full
+	if ((uint) (max_temp_data + 1) * 2 > tempDataSlots)
+	{
+		T_TEMPDATA ** old = tempData;
+		uint oldSlots = tempDataSlots;
+
+		tempDataSlots = tempDataSlots? tempDataSlots * 2:C_TEMP_DATA_SLOTS;
+		tempData = my_calloc(tempDataSlots * sizeof(T_TEMPDATA *));
+		for (i = 0; i < oldSlots; i++)
+		{
+			if (old[i])
+			{
+				uint j;
+
+				for (j = old[i]->hash & (tempDataSlots - 1); tempData[j]; j = (j + 1) & (tempDataSlots - 1));
+				tempData[j] = old[i];
+			}
+		}
+		if (old) my_free(old);
+	}
+
+	for (i = entry->hash & (tempDataSlots - 1); tempData[i]; i = (i + 1) & (tempDataSlots - 1));
+	tempData[i] = entry;
+	max_temp_data++;
+
+	// Chain it within its object bucket
+	bucket = ____tempObjectBucket(&entry->name[1]);
+	entry->next = *bucket;
+	if (*bucket) (*bucket)->prev = &entry->next;
+	entry->prev = bucket;
+	*bucket = entry;
+
+	return true;
+}
+
+static T_TEMPDATA * ____tempRemove(int slot)
+{
+	uint i = slot;
+	uint j, k;
+	T_TEMPDATA * entry = tempData[slot];
+
+	// Unchain it from its object bucket
+	*entry->prev = entry->next;
+	if (entry->next) entry->next->prev = entry->prev;
+
+	// Move back any following entries that would no longer be reachable from their home slot
+	for (j = (i + 1) & (tempDataSlots - 1); tempData[j]; j = (j + 1) & (tempDataSlots - 1))
+	{
+		k = tempData[j]->hash & (tempDataSlots - 1);
+		if ((j > i && (k <= i || k > j)) || (j < i && k <= i && k > j))
+		{
+			tempData[i] = tempData[j];
+			i = j;
+		}
+	}
+	tempData[i] = NULL;
+	max_temp_data--;
+
+	return entry;
+}
+
+//
+// Data changes are counted per object. Elements of an object array (BASE0, BASE1 or their files BASE#0...)
+// share the counter of their base name as deleting one of them renames the ones following.
+//
+static uint ____dataBucket(char * name)
+{
+	int length;
+
+	while (*name == '/') name++;
+	for (length = 0; name[length] && name[length] != '/'; length++);
+	while (length && name[length-1] >= '0' && name[length-1] <= '9') length--;
+	if (length && name[length-1] == '#') length--;
+
+	return ____hash(name, length) & (C_DATA_GENERATIONS - 1);
+}
+
+static void ____dataRead(char * fullName)
+{
+	if (dependency)
+		dependency->buckets |= 1UL << ____dataBucket(fullName);
+}
+
+static void ____dataChanged(char * objectName)
+{
+	int i;
+
+	dataChanges++;
+
+	if (objectName)
+		dataGeneration[____dataBucket(objectName)]++;
+	else for (i = 0; i < C_DATA_GENERATIONS; i++)
+		dataGeneration[i]++;
+}
+
+static ulong ____dataGeneration(ulong buckets)
+{
+	int i;
+	ulong generation = 0;
+
+	for (i = 0; buckets; i++, buckets >>= 1)
+	{
+		if (buckets & 1)
+			generation += dataGeneration[i];
+	}
+
+	return generation;
+}
+
+//
+//-------------------------------------------------------------------------------------------
+// FUNCTION   : IRIS_TrackDependencies
+//
+// DESCRIPTION:	Starts recording the data and functions the values resolved from now on depend on.
+//				Recording stops when called again with NULL.
+//
+// PARAMETERS:	track	<=	Where to record the dependencies or NULL to stop recording
+//
+// RETURNS:		None
+//-------------------------------------------------------------------------------------------
+//
+void IRIS_TrackDependencies(T_DEPENDENCY * track)
+{
+	if (track)
+	{
+		memset(track, 0, sizeof(T_DEPENDENCY));
+		dependencyChanges = dataChanges;
+	}
+	else if (dependency)
+	{
+		// Values that changed data while being resolved cannot be trusted to stay the same
+		if (dataChanges != dependencyChanges)
+			dependency->changing = true;
+		dependency->generation = ____dataGeneration(dependency->buckets);
+	}
+
+	dependency = track;
+}
+
+//
+//-------------------------------------------------------------------------------------------
+// FUNCTION   : IRIS_DependencyChanged
+//
+// DESCRIPTION:	Checks whether the values recorded by IRIS_TrackDependencies() may resolve differently now
+//
+// PARAMETERS:	track	<=	The recorded dependencies
+//
+// RETURNS:		true if anything they depend on has changed or may have changed
+//-------------------------------------------------------------------------------------------
+//
+bool IRIS_DependencyChanged(T_DEPENDENCY * track)
+{
+	return (bool) (track->changing || ____dataGeneration(track->buckets) != track->generation);
 }
 
 //
@@ -1367,6 +4368,7 @@ static void ____toNonArray(char * rsimple)
 	char index[100];
 	bool array = false;
 	int indexNum = 0;
+	T_TEMPDATA * data;
 
 	// Initialisation
 	memset(nonArray, 0, sizeof(nonArray));
@@ -1414,7 +4416,7 @@ static void ____toNonArray(char * rsimple)
 				if (stackIndex != myStackIndex)
 				{
 					if (IRIS_StackGet(0))
-						indexNum = atol(IRIS_StackGet(0));
+						indexNum = IRIS_StackGetNumber(0);
 					else
 						indexNum = 0;
 					IRIS_StackPop(stackIndex - myStackIndex);
@@ -1429,17 +4431,11 @@ static void ____toNonArray(char * rsimple)
 				sprintf(index, "%s%s", (nonArray[0] == '/' && nonArray[1] == '/')?&nonArray[1]:nonArray, indexTrailer);
 
 				// If it is found in the data array, get it's value
-				for (k = 0; k < max_temp_data; k++)
-				{
-					if (tempData[k].name && strcmp(tempData[k].name, index) == 0 && (tempData[k].group[0] == '\0' || strcmp(tempData[k].group, currentObjectGroup) == 0 || strcmp(currentObjectGroup, irisGroup) == 0))
-					{
-						indexNum = atol(tempData[k].value);
-						break;
-					}
-				}
+				if ((data = ____tempData(index)) != NULL && (data->group[0] == '\0' || strcmp(data->group, currentObjectGroup) == 0 || strcmp(currentObjectGroup, irisGroup) == 0))
+					indexNum = atol(data->value);
 
 				// If not, set the internal index but only if if is not explicitly addressed
-				if (k == max_temp_data)
+				else
 					indexNum = 0;
 			}
 
@@ -1468,6 +4464,7 @@ void IRIS_ResolveToSingleValue(char * value, bool partial)
 	{
 		int i;
 		char * simple = &value[4];
+		T_TEMPDATA * data;
 
 		// If a conversion is requested first, remember that
 		if (simple[0] == '\\')
@@ -1484,11 +4481,23 @@ void IRIS_ResolveToSingleValue(char * value, bool partial)
 			}
 		}
 
-		// If it is a function
+		// If it is a function. Its position within the function table is remembered in the value header
+		// so a value that is evaluated repeatedly (eg. a kept display object value) is only looked up once.
 		if (simple[0] == '(' && simple[1] == ')')
 		{
-			if (IRIS_StackPushFunc(simple))
+			if (simple == &value[4] && value[2])
+			{
+				____stackPushFunc((uchar) value[2] - 1);
+				return;
+			}
+
+			if ((i = ____findFunc(simple)) != -1)
+			{
+				if (simple == &value[4])
+					value[2] = i + 1;
+				____stackPushFunc(i);
 				return;
+			}
 		}
 
 		// If it starts with a '@' then it is a reference to an object TYPE string in the format @type/string
@@ -1500,33 +4509,31 @@ void IRIS_ResolveToSingleValue(char * value, bool partial)
 			char * tempStringData;
 			uint length;
 
+			// The type object depends on an index so do not try to follow it
+			if (dependency)
+				dependency->changing = true;
+
 			// Create a temporary index string
 			for (j = 0; j < (int) strlen(simple) && simple[j] != '/'; j++)
 				temp[j] = simple[j];
 			strcpy(&temp[j], indexTrailer);
 
 			// Look for the index in the temporary data array area
-			for (i = 0;  i < max_temp_data; i++)
+			if ((data = ____tempData(temp)) != NULL)
 			{
-				// If we find it, stop
-				if (tempData[i].name && strcmp(tempData[i].name, temp) == 0)
+				// If we find it and the caller is requesting only the index, push the index value onto the stack
+				if (strstr(simple, indexTrailer))
 				{
-					// If we find it and the caller is requesting only the index, push the index value onto the stack
-					if (strstr(simple, indexTrailer))
-					{
-						if (tempData[i].group[0] == '\0' || strcmp(tempData[i].group, currentObjectGroup) == 0 || strcmp(currentObjectGroup, irisGroup) == 0)
-							IRIS_Eval(tempData[i].value, false);
-						else
-							IRIS_StackPush(NULL);
-						return;
-					}
-					break;
+					if (data->group[0] == '\0' || strcmp(data->group, currentObjectGroup) == 0 || strcmp(currentObjectGroup, irisGroup) == 0)
+						IRIS_Eval(data->value, false);
+					else
+						IRIS_StackPush(NULL);
+					return;
 				}
 			}
 
 			// If the index is not found, assume its value = 0;
-			if (i == max_temp_data) i = 0;
-			else i = (tempData[i].value?atol(tempData[i].value):0);
+			i = data? atol(data->value):0;
 
 			// Prepare the object name on its own then attempt to get the object data
 			temp[j] = '\0';
@@ -1557,6 +4564,7 @@ void IRIS_ResolveToSingleValue(char * value, bool partial)
 
 			// Obtain the full name and resolve array subscripts
 			IRIS_FullName(simpler, fullName);
+			____dataRead(fullName);
 
 			// If this is an object name request, then just return the object name itself as the value
 			if (fullName[1] == '/' && strchr(&fullName[2], '/') == NULL)
@@ -1568,17 +4576,10 @@ void IRIS_ResolveToSingleValue(char * value, bool partial)
 			// If this is an object name request with a single '/', then just return the object name itself as the value but only if it exists...
 			if (strchr(&fullName[1], '/') == NULL)
 			{
-				if (fullName[1])
+				if (fullName[1] && !IRIS_ObjectExists(&fullName[1]))
 				{
-					FILE_HANDLE handle;
-					handle = open(&fullName[1], FH_RDONLY);
-					if (FH_ERR(handle))
-					{
-						IRIS_StackPush(NULL);
-						return;
-					}
-					else
-						close(handle);
+					IRIS_StackPush(NULL);
+					return;
 				}
 
 				IRIS_StackPush(fullName);
@@ -1588,23 +4589,20 @@ void IRIS_ResolveToSingleValue(char * value, bool partial)
 			// If this is the count variable, get the count instead
 			if (strstr(fullName, countTrailer))
 			{
-				char temp[10];
-				IRIS_StackPush(ltoa(IRIS_GetCount(fullName), temp, 10));
+				IRIS_StackPushNumber(IRIS_GetCount(fullName));
 				return;
 			}
 
 			// If it is found in the data array, return it.
-			for (i = 0; i < max_temp_data; i++)
+			if ((data = ____tempData(fullName)) != NULL || (partial == true && (data = ____tempPrefix(fullName)) != NULL))
 			{
-				if ((partial == false && tempData[i].name && strcmp(tempData[i].name, fullName) == 0) ||
-					(partial == true && tempData[i].name && strncmp(tempData[i].name, fullName, strlen(fullName)) == 0))
-				{
-					if (tempData[i].group[0] == '\0' || strcmp(tempData[i].group, currentObjectGroup) == 0 || strcmp(currentObjectGroup, irisGroup) == 0)
-						IRIS_Eval(tempData[i].value, false);
-					else
-						IRIS_StackPush(NULL);
-					return;
-				}
+				if (data->group[0] != '\0' && strcmp(data->group, currentObjectGroup) && strcmp(currentObjectGroup, irisGroup))
+					IRIS_StackPush(NULL);
+				else if (data->flag & C_TEMP_BYTES)
+					IRIS_StackPushBlob(data->value, data->length);
+				else
+					IRIS_Eval(data->value, false);
+				return;
 			}
 
 			// If it is not data, then possibly a string within the current object OR a different object. Resolve that if found.
@@ -1637,34 +4635,72 @@ void IRIS_ResolveToSingleValue(char * value, bool partial)
 		{
 			int myStackIndex = stackIndex;
 			char * singleValue = NULL;
-			int size = 0;
+			char * ptr;
+			uint textSize = 0;
+			uint byteSize = 0;
+			bool text = false;
+			bool bytes = false;
 
 			// Resolve each value within the array in order to concatenate them later
 			for (; *array1; array1++)
 				IRIS_ResolveToSingleValue(*array1, false);
 
-			// Concatenate all values stored in the stack
+			// Size the result in one pass over the values stored in the stack
 			for (i = myStackIndex+1; i <= stackIndex; i++)
 			{
-				if (stack[i].value)
+				if (stack[i].type == C_STACK_BLOB)
 				{
-					size = strlen(stack[i].value) + (singleValue?strlen(singleValue):0) + 1;
-					if (singleValue)
-						singleValue	= my_realloc(singleValue, size);
-					else
-						singleValue = my_calloc(size);
-					strcat(singleValue, stack[i].value);
+					byteSize += stack[i].length;
+					bytes = true;
+				}
+				else if (____stackText(&stack[i]))
+				{
+					textSize += strlen(stack[i].value);
+					text = true;
+				}
+			}
+
+			// Byte arrays on their own are concatenated as bytes. Otherwise they are added as ASCII hex like any other text.
+			if (text || bytes)
+			{
+				ptr = singleValue = my_malloc((text? (textSize + byteSize * 2):byteSize) + 1);
+				for (i = myStackIndex+1; i <= stackIndex; i++)
+				{
+					if (stack[i].type == C_STACK_BLOB && !text)
+					{
+						memcpy(ptr, stack[i].pointer, stack[i].length);
+						ptr += stack[i].length;
+					}
+					else if (stack[i].type == C_STACK_BLOB)
+					{
+						UtilHexToString(stack[i].pointer, stack[i].length, ptr);
+						ptr += stack[i].length * 2;
+					}
+					else if (stack[i].value)
+					{
+						strcpy(ptr, stack[i].value);
+						ptr += strlen(ptr);
+					}
 				}
+				*ptr = '\0';
 			}
 
 			// Pop all the values concatenated
 			IRIS_StackPop(stackIndex-myStackIndex);
 
-			// Push the newly concatenated value onto the stack
+			// Push the newly concatenated value onto the stack. It is handed over to the stack as it is.
 			stackLevel--;
-			IRIS_StackPush(singleValue);
+			if (text)
+				____stackPush(C_STACK_STRING, singleValue);
+			else if (bytes)
+			{
+				stack[stackIndex+1].pointer = singleValue;
+				stack[stackIndex+1].length = byteSize;
+				____stackPush(C_STACK_BLOB, NULL);
+			}
+			else
+				IRIS_StackPush(NULL);
 //			IRIS_Eval(singleValue, false);	// The idea here is for some variablesx to hold part of the evaluation string and then bringing them together will get another. Re-visit later. "{,,,},{,,,}" did not work. Only picked up the first object.
-			if (singleValue) my_free(singleValue);
 		}
 
 		// If the first value is another array, then this is a CONDITION (special array of arrays!!):
@@ -1678,13 +4714,10 @@ void IRIS_ResolveToSingleValue(char * value, bool partial)
 			// This array of arrays must be the last parameter requested by the function or this will not work properly.
 			if (arrayOfArraysFlag)
 			{
-				char location[20];
-
 				arrayOfArraysFlag = false;
-				sprintf(location, "%ld", array1);
 				stackLevel--;
-				IRIS_StackPush("POINTER");
-				IRIS_StackPush(location);
+				IRIS_StackPushConst("POINTER");
+				IRIS_StackPushPointer(array1);
 				return;
 			}
 
@@ -1900,8 +4933,10 @@ void IRIS_ResolveToSingleValue(char * value, bool partial)
 void IRIS_RenameObject(char * objectData, char * newName)
 {
 	char * namePtr;
+	char fileName[100];
+	char * file = IRIS_ObjectFileName(newName, fileName, true);
 
-	FILE_HANDLE handle = open(newName, FH_NEW);
+	FILE_HANDLE handle = open(file, FH_NEW);
 
 	// Find the start of the name label
 	namePtr = strstr(objectData, "NAME:");
@@ -1918,6 +4953,9 @@ void IRIS_RenameObject(char * objectData, char * newName)
 	namePtr = strchr(namePtr+1, ',');
 	write(handle, namePtr+1, strlen(namePtr+1));
 	close(handle);
+
+	IRIS_ResetObjectJournal(file);
+	IRIS_UpdateManifest(file, objectData, strlen(objectData));
 }
 
 //
@@ -1933,34 +4971,33 @@ void IRIS_RenameObject(char * objectData, char * newName)
 //
 void IRIS_ProcessActionObject(char * objectData)
 {
-	int i;
 	int myStackIndex;
 	const char operators[] = {'=', '+', '-', '/', '*', '%', '&', '^', '|', '>', '<'};	// Also ++, --, << and >>
+	int objectSize = strlen(objectData);
+	int position = 0;
+	char stringName[50];
+	char * stringValue;
+
+	// All permanent data updated by the action object is written once at the end
+	IRIS_BeginBatch();
 
-	// Get one string at a time
-	for (i = 0; ; i++, IRIS_StackPop(stackIndex-myStackIndex))
+	// Get one string at a time in a single pass over the object
+	for (myStackIndex = stackIndex; (stringValue = IRIS_NextStringValue(objectData, objectSize, &position, stringName, sizeof(stringName))) != NULL; IRIS_StackPop(stackIndex-myStackIndex))
 	{
 		int j;
 		int size;
-		char stringName[50];
 		char temp[100];
-		char * stringValue;
 		char operator[3];
 		char * first, * second, * result;
 		uchar * firstHex, * secondHex;
+		char * blob;
+		uint blobLength;
 		bool deleteFlag = false;
 		bool emptySecond = false;
 
 		// Make sure we know where we are in the stack
 		myStackIndex = stackIndex;
 
-		// Get one string at a time by setting the appropriate position number
-		sprintf(stringName, "%d", i);
-
-		// Get the proper string name and value of the position requested
-		if ((stringValue = IRIS_GetStringValue(objectData, strlen(objectData), stringName, false)) == NULL)
-			break;
-
 		// Extract any possible single operators which would have been appended to the string name
 		memset(operator, 0, sizeof(operator));
 		for (j = 0; j < sizeof(operators); j++)
@@ -1984,9 +5021,20 @@ void IRIS_ProcessActionObject(char * objectData)
 		if (stringValue[0] == 0 && stringValue[4] == '\0') emptySecond = true;
 		IRIS_ResolveToSingleValue(stringValue, false);
 		IRIS_DeallocateStringValue(stringValue);	// No need for the string value past this point
-		second = IRIS_StackGet(0);				// We now have a reference to the assignment
-		if (second && strcmp(second, "NULL") == 0)
+
+		// A byte array assigned as is keeps its bytes. Otherwise we work with text
+		if ((operator[0] == '\0' || operator[0] == '=') && ____stackIsBlob(0))
+		{
+			blob = IRIS_StackGetBytes(0, &blobLength);
 			second = NULL;
+		}
+		else
+		{
+			blob = NULL;
+			second = IRIS_StackGet(0);				// We now have a reference to the assignment
+			if (second && strcmp(second, "NULL") == 0)
+				second = NULL;
+		}
 
 		// Obtain the current value of the string if it is not an assigment
 		if (operator[0] != '\0' && operator[0] != '=')
@@ -2144,7 +5192,7 @@ void IRIS_ProcessActionObject(char * objectData)
 
 						// If the there is a number at the end of the object name (ie an array object), then this is used to delete a single object array without shifting downwards.
 						if (first[strlen(first)-1] >= '0' && first[strlen(first)-1] <= '9')
-							_remove(&first[1]);
+							IRIS_RemoveObject(&first[1]);
 
 						// Otherwise, find all the object arrays and remove them sequentially...
 						else for (count = 0; count < max; count++)
@@ -2153,7 +5201,7 @@ void IRIS_ProcessActionObject(char * objectData)
 #ifdef _DEBUG
 							printf("Removing Object ====> %s\n", temp);
 #endif
-							if (_remove(temp) == -1)
+							if (IRIS_RemoveObject(temp) == -1)
 							{
 								if (!second || second[0] == '\0')
 									break;
@@ -2190,7 +5238,6 @@ void IRIS_ProcessActionObject(char * objectData)
 					{
 						IRIS_RenameObject(data, &first[1]);
 						my_free(data);
-						IRIS_TemporaryObjectStringValue(NULL, false);
 					}
 				}
 				break;
@@ -2204,11 +5251,15 @@ void IRIS_ProcessActionObject(char * objectData)
 		IRIS_FullName(stringName, temp);
 
 		// Store the result
-		if (temp[0] && (operator[0] != '<' || operator[1] != '\0') && (operator[0] != '>' || operator[1] != '>'))
+		if (temp[0] && blob)
+			IRIS_StoreBytes(temp, blob, blobLength);
+		else if (temp[0] && (operator[0] != '<' || operator[1] != '\0') && (operator[0] != '>' || operator[1] != '>'))
 			IRIS_StoreData(temp, result, deleteFlag);
 
 		if (result) my_free(result);
 	}
+
+	IRIS_CommitBatch(false);
 }
 
 //
@@ -2223,7 +5274,7 @@ void IRIS_ProcessActionObject(char * objectData)
 // RETURNS:		None
 //-------------------------------------------------------------------------------------------
 //
-void IRIS_Eval(char * value, bool partial)
+static char * ____parseEval(char * value)
 {
 	char * evalObject = my_malloc(strlen(value)+10);
 	char * resolvableStringValue;
@@ -2234,7 +5285,60 @@ void IRIS_Eval(char * value, bool partial)
 	resolvableStringValue = IRIS_GetStringValue(evalObject, strlen(evalObject), "EVAL", false);
 	my_free(evalObject);
 
+	return resolvableStringValue;
+}
+
+void IRIS_Eval(char * value, bool partial)
+{
+	int i;
+	int length = strlen(value);
+	uint hash;
+	T_EVAL_CACHE * entry = NULL;
+	char * resolvableStringValue;
+
+	// Short strings are looked up by content in the cache of parsed strings
+	if (length <= C_EVAL_CACHE_MAX_SOURCE)
+	{
+		hash = ____hash(value, length);
+		for (i = 0; i < C_EVAL_CACHE_ENTRIES; i++)
+		{
+			if (evalCache[i].source && evalCache[i].hash == hash && strcmp(evalCache[i].source, value) == 0)
+			{
+				entry = &evalCache[i];
+				break;
+			}
+		}
+
+		// If not there, parse it into the least recently used entry not being evaluated
+		if (entry == NULL)
+		{
+			for (i = 0; i < C_EVAL_CACHE_ENTRIES; i++)
+			{
+				if (evalCache[i].busy == 0 && (entry == NULL || evalCache[i].lastUsed < entry->lastUsed))
+					entry = &evalCache[i];
+			}
+
+			if (entry)
+			{
+				UtilStrDup(&entry->source, value);
+				IRIS_DeallocateStringValue(entry->tree);
+				entry->tree = ____parseEval(value);
+				entry->hash = hash;
+			}
+		}
+	}
+
 	// Resolve it to a single simple string. Result in the stack
+	if (entry)
+	{
+		entry->lastUsed = ++evalCacheTick;
+		entry->busy++;
+		IRIS_ResolveToSingleValue(entry->tree, partial);
+		entry->busy--;
+		return;
+	}
+
+	resolvableStringValue = ____parseEval(value);
 	IRIS_ResolveToSingleValue(resolvableStringValue, partial);
 
 	// Finally lose the resolvable string
@@ -2266,6 +5370,119 @@ void IRIS_FullName(char * string, char * fullName)
 	____toNonArray(fullName);
 }
 
+//
+//-----------------------------------------------------------------------------
+// FUNCTION   : Temporary data arrays
+//
+// DESCRIPTION:	Every path component of a temporary data name ending with a number is an
+//				element of an array (eg. /SAF/ITEM3/AMT is within element 3 of /SAF/ITEM).
+//				The number of temporary data names within each element is kept up to date
+//				as names are stored and deleted so the count of an array is known without
+//				evaluating each element in turn. Names stored for a group are counted too as
+//				they may not be visible to every object.
+//
+//-----------------------------------------------------------------------------
+//
+static T_TEMP_ARRAY * ____tempArray(char * base, int length, bool add)
+{
+	uint i;
+
+	// Grow the table when it is half full
+	if (add && (tempArrayCount + 1) * 2 > tempArraySlots)
+	{
+		T_TEMP_ARRAY * old = tempArray;
+		uint oldSlots = tempArraySlots;
+
+		tempArraySlots = tempArraySlots? tempArraySlots * 2:32;
+		tempArray = my_calloc(tempArraySlots * sizeof(T_TEMP_ARRAY));
+		for (i = 0; i < oldSlots; i++)
+		{
+			if (old[i].base)
+			{
+				uint j;
+
+				for (j = ____hash(old[i].base, strlen(old[i].base)) & (tempArraySlots - 1); tempArray[j].base; j = (j + 1) & (tempArraySlots - 1));
+				tempArray[j] = old[i];
+			}
+		}
+		if (old) my_free(old);
+	}
+
+	if (tempArraySlots == 0)
+		return NULL;
+
+	for (i = ____hash(base, length) & (tempArraySlots - 1); tempArray[i].base; i = (i + 1) & (tempArraySlots - 1))
+	{
+		if ((int) strlen(tempArray[i].base) == length && strncmp(tempArray[i].base, base, length) == 0)
+			return &tempArray[i];
+	}
+
+	if (!add)
+		return NULL;
+
+	tempArray[i].base = my_malloc(length + 1);
+	memcpy(tempArray[i].base, base, length);
+	tempArray[i].base[length] = '\0';
+	tempArrayCount++;
+
+	return &tempArray[i];
+}
+
+static void ____trackTempName(char * name, int change, bool restricted)
+{
+	char * ptr;
+
+	for (ptr = name; *ptr; ptr++)
+	{
+		char * start;
+		uint index;
+		T_TEMP_ARRAY * array;
+
+		// Find the end of a path component ending with a number
+		if ((ptr[1] != '\0' && ptr[1] != '/') || *ptr < '0' || *ptr > '9') continue;
+		for (start = ptr; start > (name+1) && start[-1] >= '0' && start[-1] <= '9'; start--);
+		if (start[-1] == '/') continue;
+
+		index = atol(start);
+		if ((array = ____tempArray(name, start - name, (bool) (change > 0))) == NULL)
+			continue;
+
+		if (change > 0)
+		{
+			if (restricted) array->restricted++;
+			if (index >= array->size)
+			{
+				uint size = index + 8;
+				array->refs = array->refs? my_realloc(array->refs, size * sizeof(uint)):my_malloc(size * sizeof(uint));
+				memset(&array->refs[array->size], 0, (size - array->size) * sizeof(uint));
+				array->size = size;
+			}
+
+			// Extend the count over this element and any following elements already present
+			if (array->refs[index]++ == 0 && index == array->count)
+				while (array->count < array->size && array->refs[array->count]) array->count++;
+		}
+		else if (index < array->size && array->refs[index])
+		{
+			if (restricted && array->restricted) array->restricted--;
+			// The array now ends before an element that has gone
+			if (--array->refs[index] == 0 && index < array->count)
+				array->count = index;
+		}
+	}
+}
+
+static uint ____tempArrayCount(char * base)
+{
+	T_TEMP_ARRAY * array = ____tempArray(base, strlen(base), false);
+
+	// Elements stored for a group may not be visible so they must be evaluated one at a time
+	if (array && array->restricted && strcmp(currentObjectGroup, irisGroup))
+		return 0;
+
+	return array? array->count:0;
+}
+
 //
 //-------------------------------------------------------------------------------------------
 // FUNCTION   : IRIS_StoreData
@@ -2284,11 +5501,14 @@ void IRIS_FullName(char * string, char * fullName)
 //
 // Returns false if not enough epace
 //
-static bool ____storeData(char * string, char * value, char * group)
+static bool ____storeData(char * string, char * value, int length, char * group)
 {
 	int i;
 	char * ptr;
 	int strLen = strlen(string);
+	uint hash;
+	T_TEMPDATA * entry;
+	T_TEMPDATA * old = NULL;
 
 #ifdef _DEBUG
 	printf("Storing data:::::::::::::     %s = %s\n", string, value?value:"NULL");
@@ -2312,43 +5532,32 @@ static bool ____storeData(char * string, char * value, char * group)
 		)
 		return false;
 
-	// Locate the first empty location and delete the string and its value if available
-	for (i = 0; i < max_temp_data; i++)
-	{
-		if (tempData[i].name && string && strcmp(tempData[i].name, string) == 0)
-		{
-			UtilStrDup(&tempData[i].name, NULL);
-			UtilStrDup(&tempData[i].value, NULL);
-			UtilStrDup(&tempData[i].group, NULL);
-			break;
-		}
-	}
-
-	// If the data area is full....
-	if (i == C_MAX_TEMP_DATA)
-		return false;
+	// Delete the string and its value if available. The string may be the name within the entry so it is only freed at the end
+	hash = ____hash(string, strLen);
+	if ((i = ____tempFind(string, hash)) != -1)
+		old = ____tempRemove(i);
 
 	// If there is room and we do not want to delete, store/update the entry.
 	if (value)
 	{
-		UtilStrDup(&tempData[i].name, string);
-		UtilStrDup(&tempData[i].value, value);
-		UtilStrDup(&tempData[i].group, group);
-		if (i == max_temp_data) max_temp_data++;
-	}
-	else if (string && i < max_temp_data)
-	{
-		// Compact the temporary data
-		if (i != (max_temp_data-1))
+		entry = ____tempEntry(string, hash, value, length, group);
+
+		// If the data area is full....
+		if (____tempInsert(entry) == false)
 		{
-			tempData[i] = tempData[max_temp_data-1];
-			memset(&tempData[max_temp_data-1], 0, sizeof(T_TEMPDATA));
+			my_free(entry);
+			return false;
 		}
 
-		// We now have one less element
-		max_temp_data--;
+		// The group may have changed so the old name is no longer tracked under it
+		if (old) ____trackTempName(string, -1, (bool) (old->group[0] != '\0'));
+		____trackTempName(string, 1, (bool) (entry->group[0] != '\0'));
+	}
+	else if (old)
+	{
+		____trackTempName(string, -1, (bool) (old->group[0] != '\0'));
 
-		ptr = &string[strlen(string)-1];
+		ptr = &string[strLen-1];
 
 		// If deleting and the string ends with a number, then it is an array....
 		if (*ptr >= '0' && *ptr <= '9')
@@ -2366,21 +5575,20 @@ static bool ____storeData(char * string, char * value, char * group)
 				sprintf(fromTemp, "%.*s%d", ptr-string, string, index);
 				sprintf(toTemp, "%.*s%d", ptr-string, string, index-1);
 
-				for (i = 0; i < max_temp_data; i++)
-				{
-					if (tempData[i].name && strcmp(tempData[i].name, fromTemp) == 0)
-					{
-						UtilStrDup(&tempData[i].name, NULL);
-						UtilStrDup(&tempData[i].name, toTemp);
-						break;
-					}
-				}
+				if ((i = ____tempFind(fromTemp, ____hash(fromTemp, strlen(fromTemp)))) == -1) break;
 
-				if (i == max_temp_data) break;
+				// Renaming changes the hash so store it again under the new name
+				entry = ____tempRemove(i);
+				____tempInsert(____tempEntry(toTemp, ____hash(toTemp, strlen(toTemp)), entry->value, (entry->flag & C_TEMP_BYTES)? (int) entry->length:-1, entry->group));
+				____trackTempName(fromTemp, -1, (bool) (entry->group[0] != '\0'));
+				____trackTempName(toTemp, 1, (bool) (entry->group[0] != '\0'));
+				my_free(entry);
 			}
 		}
 	}
 
+	if (old) my_free(old);
+
 	return true;
 }
 
@@ -2390,7 +5598,20 @@ static ____remove_object(char * objectName)
 #ifdef _DEBUG
 	printf("Removing Object ====> %s\n", objectName);
 #endif
-	_remove(objectName);
+	// If this is an array element followed by other elements, keep the array in a container so the others do not need to be renamed
+	if (*ptr >= '0' && *ptr <= '9' && ____arrayBase(objectName))
+	{
+		char nextName[100];
+
+		sprintf(nextName, "%.*s%ld", ____arrayBase(objectName), objectName, atol(&objectName[____arrayBase(objectName)]) + 1);
+		if (IRIS_ObjectExists(nextName) && ____createContainer(objectName))
+		{
+			____removeObject(objectName, true);
+			return;
+		}
+	}
+
+	IRIS_RemoveObject(objectName);
 
 	// Find if there are any array files following this object and shift them downwards
 	if (*ptr >= '0' && *ptr <= '9')
@@ -2417,53 +5638,14 @@ static ____remove_object(char * objectName)
 #ifdef _DEBUG
 			printf("Renaming Object ====> from:%s to:%s\n", fromObject, toObject);
 #endif
-			_remove(fromObject);
+			IRIS_RemoveObject(fromObject);
 			my_free(nextObjectData);
 		}
 	}
-
-	IRIS_TemporaryObjectStringValue(NULL, false);
-}
-
-#ifdef _DEBUG
-static int _delete_(FILE * fp, int count, char * ptr, char * objectData, uint objectLength)
-{
-	char * restOfData = my_calloc(objectLength - (uint) (ptr - objectData) + 1);
-	long position = ftell(fp);
-
-	fread(restOfData, 1, objectLength - (uint) (ptr - objectData) + 1, fp);
-	fseek(fp, position, SEEK_SET);
-	fwrite(restOfData + count, 1, strlen(restOfData) - count + 1, fp);
-	fseek(fp, position, SEEK_SET);
-	my_free(restOfData);
-
-	// *** NOTE that this does not truncate the file but adds a null character towards the end. The file size will not change as result...
-	// If porting to other devices and using this method, deal with this please... Possibly by reading the entire file as a string and writing it back...This is how I had it in the beginning...
-
-	return 0;
-}
-
-static int _insert(FILE * fp, char * data, int count, char * ptr, char * objectData, uint objectLength)
-{
-	char * restOfData = my_calloc(objectLength - (uint) (ptr - objectData) + 1);
-	long position = ftell(fp);
-
-	fread(restOfData, 1, objectLength - (uint) (ptr - objectData) + 1, fp);
-
-	fseek(fp, position, SEEK_SET);
-	fwrite(data, 1, count,fp);
-	position = ftell(fp);
-
-	fwrite(restOfData, 1, strlen(restOfData) + 1, fp);
-	fseek(fp, position, SEEK_SET);
-	my_free(restOfData);
-
-	return count;
 }
-#endif
 
 //-------------------------------------------------------------------------------------------
-void IRIS_StoreData(char * fullName, char * value, bool deleteFlag)
+static void ____storeValue(char * fullName, char * value, int length, bool deleteFlag)
 {
 	int j;
 	int offset = 0;
@@ -2476,10 +5658,21 @@ void IRIS_StoreData(char * fullName, char * value, bool deleteFlag)
 	// Examine if we are accessing the object file itself
 	if (fullName[1] == '/') offset = 1;
 
+	// Objects are text so bytes are stored within them as ASCII hex
+	if (length >= 0 && offset == 1)
+	{
+		char * string = UtilHexToString((uchar *) value, length, my_malloc(length * 2 + 1));
+
+		____storeValue(fullName, string, -1, deleteFlag);
+		my_free(string);
+		return;
+	}
+
 	// Extract the object name on its own
 	for (j = 0; fullName[j+1+offset] != '/' && fullName[j+1+offset]; j++)
 		objectName[j] = fullName[j+1+offset];
 	objectName[j] = '\0';
+	____dataChanged(objectName);
 
 	// Get the object data
 	if ((objectData = IRIS_GetObjectData(objectName, &objectLength)) == NULL && offset == 1)
@@ -2533,7 +5726,7 @@ void IRIS_StoreData(char * fullName, char * value, bool deleteFlag)
 		{
 			// Only store if an object AND a string are specified
 			if (strchr(&fullName[1], '/') != NULL)
-				____storeData(fullName, deleteFlag?NULL:value, group?&group[4]:"");
+				____storeData(fullName, deleteFlag?NULL:value, length, group?&group[4]:"");
 		}
 		else
 		{
@@ -2645,54 +5838,11 @@ void IRIS_StoreData(char * fullName, char * value, bool deleteFlag)
 						else if (newTagValue)
 							ptr2 = ptr = strrchr(objectData,'}');
 
-						// Replace with the new tag:value
+						// Journal the new tag:value. The object file itself is only rewritten when the journal is compacted.
 						if (ptr)
 						{
-							FILE_HANDLE handle;
-
-							// Open the object file for an update
 							printf("Storing PERM data ====> %s:%s\n", fullName, value);
-							handle = open(objectName, FH_RDWR);
-							lseek(handle, ptr - objectData, SEEK_SET);
-
-							if (newTagValue && (strlen(&newTagValue[1]) == (uint) (ptr2 - ptr)))
-								write(handle, &newTagValue[1], ptr2 - ptr);
-							else
-							{
-								int offset = 0;
-								if (ptr != ptr2)
-								{
-									_delete_(handle, ptr2 - ptr, ptr, objectData, objectLength);
-									offset = 1;
-								}
-								if (newTagValue)
-									_insert(handle, &newTagValue[offset], strlen(&newTagValue[offset]), ptr, objectData, objectLength);
-							}
-
-							// If this is an array element getting deleted, then slosh all following elements backwards
-							if (!newTagValue)
-							{
-								char * ptr = &search[strlen(search) - 1];
-
-								*ptr = '\0';	// The search looses the ending colon
-								ptr--;
-								if (*ptr >= '0' && *ptr <= '9')
-								{
-									// Lose any trailing "array" digits
-									while (*ptr >= '0' && *ptr <= '9')
-									{
-										*ptr = '\0';
-										ptr--;
-									}
-
-									// Look for the next element
-									lseek(handle, 0, SEEK_SET);
-
-								}
-							}
-
-							close(handle);
-							IRIS_TemporaryObjectStringValue(NULL, false);
+							IRIS_JournalTagValue(objectName, &fullName[j+3], newTagValue?value:NULL);
 						}
 						UtilStrDup(&newTagValue, NULL);
 					}
@@ -2707,6 +5857,30 @@ void IRIS_StoreData(char * fullName, char * value, bool deleteFlag)
 	UtilStrDup(&objectData, NULL);
 }
 
+void IRIS_StoreData(char * fullName, char * value, bool deleteFlag)
+{
+	____storeValue(fullName, value, -1, deleteFlag);
+}
+
+//
+//-------------------------------------------------------------------------------------------
+// FUNCTION   : IRIS_StoreBytes
+//
+// DESCRIPTION:	Same as IRIS_StoreData() for a byte array value. Temporary data keeps the bytes
+//				as they are and reads back as a blob. Objects get the ASCII hex of the bytes.
+//
+// PARAMETERS:	fullName	<=	The fully qualified string name
+//				value		<=	The bytes
+//				length		<=	The number of bytes
+//
+// RETURNS:		None
+//-------------------------------------------------------------------------------------------
+//
+void IRIS_StoreBytes(char * fullName, char * value, uint length)
+{
+	____storeValue(fullName, value, length, false);
+}
+
 //
 //-------------------------------------------------------------------------------------------
 // FUNCTION   : IRIS_GetCount
@@ -2739,7 +5913,18 @@ int IRIS_GetCount(char * fullName)
 	{
 		int myStackIndex = stackIndex;
 
-		for(;!stop;)
+		// The count of an object array may already be known
+		*countPtr = '\0';
+		if (strchr(&array[1], '/') == NULL && (i = IRIS_ArrayCount(&array[1])) != -1)
+		{
+			stackLevel--;
+			return i;
+		}
+
+		// Elements held in the temporary data area are known to be present unless some belong to a group. Only look for more past them.
+		i = (strchr(&array[1], '/') == NULL)? -1:(int) ____tempArrayCount(array) - 1;
+
+		for(; !stop;)
 		{
 			// Look for the next array
 			sprintf(countPtr, "%d", ++i);
@@ -2747,11 +5932,8 @@ int IRIS_GetCount(char * fullName)
 			// If an object is being checked, then just examine if the file exists.
 			if (strchr(&array[1], '/') == NULL)
 			{
-				FILE_HANDLE handle;
-				handle = open(&array[1], FH_RDONLY);
-				if (FH_ERR(handle))
+				if (!IRIS_ObjectExists(&array[1]))
 					stop = true;
-				else close(handle);
 			}
 			else
 			{
@@ -2765,6 +5947,13 @@ int IRIS_GetCount(char * fullName)
 				IRIS_StackPop(stackIndex - myStackIndex);
 			}
 		}
+
+		// Remember the count of an object array until one of its elements is created or removed
+		if (strchr(&array[1], '/') == NULL)
+		{
+			*countPtr = '\0';
+			____container(&array[1], strlen(&array[1]))->known = i;
+		}
 	}
 
 	stackLevel--;
@@ -2790,24 +5979,25 @@ int IRIS_GetCount(char * fullName)
 //
 int IRIS_ClrTemp(char * objectName)
 {
-	int i;
 	int count = 0;
-	int count2 = 0;
+	int length = strlen(objectName);
+	T_TEMPDATA ** bucket = ____tempObjectBucket(objectName);
+	T_TEMPDATA * entry;
 
-	// If it is found in the data array, remove it
-	for (i = 0; i < max_temp_data; i++)
+	// If it is found in the object's data, remove it. Removing array elements renames the ones following, so start again each time
+	for (entry = *bucket; entry;)
 	{
-		if (tempData[i].name)
+		if (strncmp(&entry->name[1], objectName, length) == 0 && entry->name[1+length] == '/' &&
+			(entry->group[0] == '\0' || strcmp(entry->group, currentObjectGroup) == 0 || strcmp(currentObjectGroup, irisGroup) == 0))
 		{
-			count2++;
-			if (tempData[i].name && strncmp(&tempData[i].name[1], objectName, strlen(objectName)) == 0 && tempData[i].name[1+strlen(objectName)] == '/' &&
-				(tempData[i].group[0] == '\0' || strcmp(tempData[i].group, currentObjectGroup) == 0 || strcmp(currentObjectGroup, irisGroup) == 0))
-			{
-				count++;
-				____storeData(tempData[i--].name, NULL, NULL);
-			}
+			count++;
+			____storeData(entry->name, NULL, -1, NULL);
+			entry = *bucket;
 		}
+		else entry = entry->next;
 	}
 
+	if (count) ____dataChanged(objectName);
+
 	return count;
 }
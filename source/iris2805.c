@@ -78,7 +78,6 @@ static uchar iv_ofb[8] = "\x01\x23\x45\x67\x89\xAB\xCD\xEF";
 void __as2805_get(void)
 {
 	uint length;
-	char * string;
 	uchar * request = AS2805Position(&length);
 
 	// Release function name from stack
@@ -88,17 +87,8 @@ void __as2805_get(void)
 	if (length == 0)
 		IRIS_StackPush(NULL);
 
-	// AS2805 available. Send it back
-	else
-	{
-		// Convert the request buffer to ASCII Hex
-		string = my_malloc(length * 2 + 1);
-		UtilHexToString(request, length, string);
-
-		// return with the request buffer as a string
-		IRIS_StackPush(string);
-		my_free(string);
-	}
+	// AS2805 available. Send it back as it is
+	else IRIS_StackPushBlob((char *) request, length);
 }
 
 //
@@ -138,49 +128,36 @@ void __as2805_err(void)
 //
 void __as2805_ofb(void)
 {
-	uchar * duplicate;
-	char * request = IRIS_StackGet(0);	// This is the request in ASCII hex string
-	char * key = IRIS_StackGet(1);
 	uchar * hex;
-	int length;
+	uint length;
+	char * key = IRIS_StackGet(1);
+	uchar * request = (uchar *) IRIS_StackGetBytes(0, &length);
 
 	// Make sure we have a buffer request to process.
-	if (!key || !request || strlen(request) == 0)
+	if (!key || !request || length == 0)
 	{
 		IRIS_StackPop(3);
 		IRIS_StackPush(NULL);
 		return;
 	}
 
-	// Convert the AS2805 data back to a hex stream
-	hex = my_malloc(strlen(request)/2);
-	length = UtilStringToHex(request, strlen(request), hex);
-
-	// Create a duplicate of the stream
-	duplicate = my_malloc(length);
-	memcpy(duplicate, hex, length);
+	// Create a copy of the stream to encrypt. The request itself remains in the clear.
+	hex = my_malloc(length);
+	memcpy(hex, request, length);
 
 	// OFB encrypt the result using the key supplied
 	SecuritySetIV(iv_ofb);
 	SecurityCrypt(currentObjectGroup, (uchar) atoi(key), 16, length, hex, false, true);
 
-	// Restore the clear field from the duplicate
-	AS2805OFBAdjust(duplicate, hex, length);
-
-	// Release the duplicate copy
-	my_free(duplicate);
-
-	// Convert the hex stream to ASCII Hex
-	request = my_malloc(length * 2 + 1);
-	UtilHexToString(hex, length, request);
+	// Restore the clear field from the request
+	AS2805OFBAdjust(request, hex, length);
 
 	// We got our message now, release internal buffers
 	AS2805Close();
 
-	// return with the request buffer as a string
+	// return with the request buffer
 	IRIS_StackPop(3);
-	IRIS_StackPush(request);
-	my_free(request);
+	IRIS_StackPushBlob((char *) hex, length);
 	my_free(hex);
 }
 
@@ -204,8 +181,7 @@ void __as2805_make(void)
 	int i;
 	uint length = 0;
 	uchar * request;
-	char * string;
-	char ** arrayOfArrays = (char **) atol(IRIS_StackGet(0));		// This is potentially dangerous if a normal striong was pushed onto the stack
+	char ** arrayOfArrays = (char **) IRIS_StackGetPointer(0);
 	char * paramHealthCheck = IRIS_StackGet(1);
 
 	// Make sure we were passed a good pointer
@@ -266,7 +242,7 @@ void __as2805_make(void)
 					// Field number
 					case 0:
 						// Get the field number
-						fieldNum = atoi(IRIS_StackGet(0));
+						fieldNum = IRIS_StackGetNumber(0);
 
 						// If the field number is 64 or 128 (MAC location), then set the bit to ensure MAC calculation is OK.
 						if (fieldNum == 64 || fieldNum == 128)
@@ -300,16 +276,11 @@ void __as2805_make(void)
 		return;
 	}
 
-	// Convert the request buffer to ASCII Hex
-	string = my_malloc(length * 2 + 1);
-	UtilHexToString(request, length, string);
+	// return with the request buffer as it is
+	IRIS_StackPushBlob((char *) request, length);
 
 	// We got our message now, release internal buffers
 	AS2805Close();
-
-	// return with the request buffer as a string
-	IRIS_StackPush(string);
-	my_free(string);
 }
 
 //
@@ -332,8 +303,7 @@ void __as2805_make_custom(void)
 	int i;
 	uint length = 0;
 	uchar * request = NULL;
-	char * string;
-	char ** arrayOfArrays = (char **) atol(IRIS_StackGet(0));		// This is potentially dangerous if a normal string was pushed onto the stack
+	char ** arrayOfArrays = (char **) IRIS_StackGetPointer(0);
 	char * paramHealthCheck = IRIS_StackGet(1);
 
 	// Make sure we were passed a good pointer
@@ -429,7 +399,7 @@ void __as2805_make_custom(void)
 					case 1:
 						// Get the field number
 						if (formatType != C_LOOP && formatType != C_END_LOOP)
-							fieldSize = atoi(IRIS_StackGet(0));
+							fieldSize = IRIS_StackGetNumber(0);
 						break;
 
 					// The field value
@@ -463,17 +433,12 @@ void __as2805_make_custom(void)
 		return;
 	}
 
-	// Convert the request buffer to ASCII Hex
-	string = my_malloc(length * 2 + 1);
-	UtilHexToString(request, length, string);
+	// return with the request buffer as it is
+	IRIS_StackPushBlob((char *) request, length);
 	if (request) my_free(request);
 
 	// We got our message now, release internal buffers
 	AS2805Close();
-
-	// return with the request buffer as a string
-	IRIS_StackPush(string);
-	my_free(string);
 }
 
 
@@ -498,9 +463,9 @@ void __as2805_break(void)
 	uint length;
 	char temp[10];
 	uchar * response;
-	char ** arrayOfArrays = (char **) atol(IRIS_StackGet(0));		// This is potentially dangerous if a normal string was pushed onto the stack
+	char ** arrayOfArrays = (char **) IRIS_StackGetPointer(0);
 	char * paramHealthCheck = IRIS_StackGet(1);
-	char * data = IRIS_StackGet(2);
+	char * data = IRIS_StackGetBytes(2, &length);
 
 	// Make sure we were passed a good pointer
 	if (!data || !arrayOfArrays || !paramHealthCheck || strcmp(paramHealthCheck, "POINTER"))
@@ -510,10 +475,9 @@ void __as2805_break(void)
 		return;
 	}
 
-	// Convert the response to hex
-	length = strlen(data)/2;
+	// Take a copy of the response
 	response = my_malloc(length + 200);		// To cover ill-formatted messages
-	UtilStringToHex(data, strlen(data), response);
+	memcpy(response, data, length);
 
 	// Lose the parameters and function name.	
 	IRIS_StackPop(4);
@@ -571,7 +535,7 @@ void __as2805_break(void)
 					// Field number
 					case 1:
 						// Get the field number
-						fieldNum = atoi(IRIS_StackGet(0));
+						fieldNum = IRIS_StackGetNumber(0);
 						break;
 
 					// The field value
@@ -631,7 +595,7 @@ void __as2805_break(void)
 
 								// Add it to the new value
 								if (IRIS_StackGet(0))
-									result += atol(IRIS_StackGet(0));
+									result += IRIS_StackGetNumber(0);
 
 								// Lose the current value from the stack
 								IRIS_StackPop(1);
@@ -700,9 +664,9 @@ void __as2805_break_custom(void)
 	uint length = 0;
 	char temp[10];
 	uchar * response;
-	char ** arrayOfArrays = (char **) atol(IRIS_StackGet(0));		// This is potentially dangerous if a normal string was pushed onto the stack
+	char ** arrayOfArrays = (char **) IRIS_StackGetPointer(0);
 	char * paramHealthCheck = IRIS_StackGet(1);
-	char * data = IRIS_StackGet(2);
+	char * data = IRIS_StackGetBytes(2, &respLength);
 	bool tooLong = false;
 
 //	debug = 1;
@@ -715,10 +679,9 @@ void __as2805_break_custom(void)
 		return;
 	}
 
-	// Convert the response to hex
-	respLength = strlen(data) / 2;
+	// Take a copy of the response
 	response = my_malloc(respLength + 200);		// To cover ill formatted messages
-	UtilStringToHex(data, strlen(data), response);
+	memcpy(response, data, respLength);
 
 	// Lose the parameters and function name.	
 	IRIS_StackPop(4);
@@ -818,7 +781,7 @@ void __as2805_break_custom(void)
 					case 2:
 						// Get the field number
 						if (operation != C_LOOP && operation != C_END_LOOP)
-							fieldSize = atoi(IRIS_StackGet(0));
+							fieldSize = IRIS_StackGetNumber(0);
 						break;
 
 					// The field value
@@ -829,7 +792,7 @@ void __as2805_break_custom(void)
 
 						// If we get a value from the initial loop construct, skip that many from the body of the loop and possibly beyond
 						else if (operation ==  C_LOOP && IRIS_StackGet(0))
-							arrayOfArrays += atoi(IRIS_StackGet(0));
+							arrayOfArrays += IRIS_StackGetNumber(0);
 
 						// Get the field value
 						else if (operation != C_LOOP && operation != C_END_LOOP)
@@ -892,7 +855,7 @@ void __as2805_break_custom(void)
 
 									// Add it to the new value
 									if (IRIS_StackGet(0))
-										result += atol(IRIS_StackGet(0));
+										result += IRIS_StackGetNumber(0);
 
 									// Lose the current value from the stack
 									IRIS_StackPop(1);
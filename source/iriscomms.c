@@ -72,20 +72,19 @@
 //
 void IRIS_CommsSend(T_COMMS * comms, int * retVal)
 {
-	char * data = IRIS_StackGet(0);
+	uint length;
+	char * data = IRIS_StackGetBytes(0, &length);
 
 	// If not connected, return an error
 	if (comms->wHandle == 0xFFFF)
 		*retVal = ERR_COMMS_CONNECT_FAILURE;
 
-	else if (data && strlen(data) >= 2)
+	else if (data && length)
 	{
-		// Get the buffer length in hex bytes
-		comms->wLength = strlen(data) / 2;
-
-		// Allocate and fill up the hex buffer
+		// Copy the bytes as the communication layer may add a header in front of them
+		comms->wLength = length;
 		comms->pbData = my_malloc(comms->wLength);
-		UtilStringToHex(data, comms->wLength * 2, comms->pbData);
+		memcpy(comms->pbData, data, comms->wLength);
 
 /*																		{
 																			char tempBuf[40];
@@ -124,7 +123,6 @@ void IRIS_CommsSend(T_COMMS * comms, int * retVal)
 //
 void IRIS_CommsRecv(T_COMMS * comms, int bufLen, int * retVal)
 {
-	char * string;
 	char * interCharTimeout = IRIS_StackGet(0);
 	char * timeout = IRIS_StackGet(1);
 
@@ -148,7 +146,7 @@ void IRIS_CommsRecv(T_COMMS * comms, int bufLen, int * retVal)
 		comms->dwInterCharTimeout = atol(interCharTimeout);
 
 	// Allocate the receive buffer and set the maximum receive length
-	comms->pbData = my_malloc(bufLen);
+	comms->pbData = my_malloc(bufLen + 1);
 	comms->wLength = bufLen;
 
 //																		if (debug)
@@ -174,18 +172,20 @@ void IRIS_CommsRecv(T_COMMS * comms, int bufLen, int * retVal)
 	// Clear the stack
 	IRIS_StackPop(3);
 
-	// Return the received data or empty if error
+	// Return the received data or empty if error. The receive buffer is handed over to the stack rather than copied
 	if (*retVal == ERR_COMMS_NONE && comms->wLength)
 	{
-		string = my_malloc(comms->wLength * 2 + 1);
-		UtilHexToString(comms->pbData, comms->wLength, string);
-		IRIS_StackPush(string);
-		my_free(string);
+		comms->pbData[comms->wLength] = '\0';
+		IRIS_StackPushAllocatedBlob((char *) comms->pbData, comms->wLength);
+		comms->pbData = NULL;
 	}
-	else IRIS_StackPush(NULL);
+	else
+	{
+		IRIS_StackPush(NULL);
 
-	// Release the receive buffer as it is not needed now
-	UtilStrDup((char **) &comms->pbData, NULL);
+		// Release the receive buffer as it is not needed now
+		UtilStrDup((char **) &comms->pbData, NULL);
+	}
 }
 
 //
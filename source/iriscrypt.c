@@ -291,9 +291,9 @@ void __iv_clr(void)
 void __crypt(void)
 {
 	uchar * hex;
-	char * string = NULL;
+	uint length;
 
-	char * data = IRIS_StackGet(0);
+	char * data = IRIS_StackGetBytes(0, &length);
 	char * keySize = IRIS_StackGet(1);
 	char * key = IRIS_StackGet(2);
 	char * variant = IRIS_StackGet(3);
@@ -304,12 +304,13 @@ void __crypt(void)
 
 	if (data && key && variant && func)
 	{
-		int size = strlen(data) / 2 + 1;
+		int size = length + 1;
 		if (size/8*8 != size) size = size/8*8+8;
 
-		// Change the ASCII data to hex digits.
+		// Work on a copy of the data padded for the cipher block size
 		hex = my_calloc(size);
-		size = UtilStringToHex(data, strlen(data), hex);
+		memcpy(hex, data, length);
+		size = length;
 
 		// Perform the encryption
 		if (strcmp(func, "()ENCV") == 0 || strcmp(func, "()DECV") == 0)
@@ -324,29 +325,28 @@ void __crypt(void)
 		else
 			SecurityCrypt(currentObjectGroup, (uchar) atoi(key), (uchar) ((keySize && keySize[0] == '8')?8:16), size, hex, (bool) (strcmp(func,"()ENC")?true:false), (bool) (strcmp(func,"()OFB")?false:true));
 
-		// Change back to ASCII data
-		string = my_malloc(size*2 + 1);
-		UtilHexToString(hex, size, string);
-		my_free(hex);
-
 		// Lose the function name and parameters since they are no longer needed
 		IRIS_StackPop(4);
 		if (strcmp(func, "()ENCV") == 0 || strcmp(func, "()DECV") == 0)
 			IRIS_StackPop(1);
 
-		// Push the result onto the stack
-		IRIS_StackPush(string);
-		my_free(string);
+		// Push the result onto the stack. The padded copy is handed over rather than copied again
+		IRIS_StackPushAllocatedBlob((char *) hex, size);
 	}
 	else
 	{
 		// Send the data back as is if an error occurs
-		UtilStrDup(&string, data);
+		hex = NULL;
+		if (data)
+		{
+			hex = my_malloc(length);
+			memcpy(hex, data, length);
+		}
 		IRIS_StackPop(4);
 		if (func && (strcmp(func, "()ENCV") == 0 || strcmp(func, "()DECV") == 0))
 			IRIS_StackPop(1);
-		IRIS_StackPush(string);
-		UtilStrDup(&string, NULL);
+		IRIS_StackPushBlob((char *) hex, length);
+		if (hex) my_free(hex);
 	}
 }
 
@@ -363,44 +363,33 @@ void __crypt(void)
 //
 void __mac(void)
 {
-	uchar * hex;
+	uint size;
 	uchar hexVariant[2];
 	uchar hexMAC[8];
-	char mac[17];
 
-	char * data = IRIS_StackGet(0);
+	uchar * hex = (uchar *) IRIS_StackGetBytes(0, &size);
 	char * variant = IRIS_StackGet(1);
 	char * key = IRIS_StackGet(2);
 
-	strcpy(mac, "0000000000000000");
+	memset(hexMAC, 0, sizeof(hexMAC));
 
-	if (data && variant && key)
+	if (hex && variant && key)
 	{
-		int size = strlen(data) / 2;
-
-		// Change the ASCII data to hex digits.
-		hex = my_malloc(size + 1);
-		size = UtilStringToHex(data, strlen(data), hex);
-
 		// Change the ASCII variant to hex digits.
 		UtilStringToHex(variant, sizeof(hexVariant), hexVariant);
 
 		// Perform the MAC calculation
 		SecurityMAB(currentObjectGroup, (uchar) atoi(key), 16, size, hex, strlen(variant) == 4?hexVariant:NULL, hexMAC);
-		my_free(hex);
 
 		// Clear the last 4 bytes since this is a MAC
 		hexMAC[4] = hexMAC[5] = hexMAC[6] = hexMAC[7] = 0;
-
-		// Change back to ASCII data
-		UtilHexToString(hexMAC, sizeof(hexMAC), mac);
 	}
 
 	// Lose the function name and parameters since they are no longer needed
 	IRIS_StackPop(4);
 
-	// Push the result onto the stack and clean up
-	IRIS_StackPush(mac);
+	// Push the result onto the stack
+	IRIS_StackPushBlob((char *) hexMAC, sizeof(hexMAC));
 }
 
 
@@ -418,26 +407,19 @@ void __mac(void)
 void __kvc(void)
 {
 	uchar hexKVC[3];
-	char kvc[7];
 
 	char * keySize = IRIS_StackGet(0);
 	char * key = IRIS_StackGet(1);
 
-	strcpy(kvc, "000000");
-
-	if (key)
-	{
-		// Perform the encryption
-		if (SecurityKVCKey(currentObjectGroup, (uchar) atoi(key), (uchar) ((keySize && atoi(keySize) == 8)?8:16), hexKVC))
-			// Change to ASCII hex data
-			UtilHexToString(hexKVC, sizeof(hexKVC), kvc);
-	}
+	// Perform the encryption
+	if (!key || !SecurityKVCKey(currentObjectGroup, (uchar) atoi(key), (uchar) ((keySize && atoi(keySize) == 8)?8:16), hexKVC))
+		memset(hexKVC, 0, sizeof(hexKVC));
 
 	// Lose the function name and parameters since they are no longer needed
 	IRIS_StackPop(3);
 
 	// Push the result onto the stack
-	IRIS_StackPush(kvc);
+	IRIS_StackPushBlob((char *) hexKVC, sizeof(hexKVC));
 }
 
 
@@ -42,44 +42,44 @@
 //
 const T_IRIS_FUNC irisFunc[C_NO_OF_IRIS_FUNCTIONS] =
 {
-	{"()STRIP",				1, false,	__strip},
-	{"()PAD",				2, false,	__pad},
-	{"()SUBSTRING",			2, false,	__substring},
-	{"()TO_AHEX",			1, false,	__to_ascii_hex},
-	{"()TO_HEX",			1, false,	__to_hex},
-	{"()TO_SAFE_HEX",		1, false,	__to_safe_hex},
-	{"()CHECKSUM_XOR",		5, false,	__checksum_xor},
-	{"()CHECKSUM_SUM",		5, false,	__checksum_sum},
+	{"()STRIP",				1, false,	__strip,		0, true},
+	{"()PAD",				2, false,	__pad,			0, true},
+	{"()SUBSTRING",			2, false,	__substring,	0, true},
+	{"()TO_AHEX",			1, false,	__to_ascii_hex,	0, true},
+	{"()TO_HEX",			1, false,	__to_hex,		0, true},
+	{"()TO_SAFE_HEX",		1, false,	__to_safe_hex,	0, true},
+	{"()CHECKSUM_XOR",		5, false,	__checksum_xor,	0, true},
+	{"()CHECKSUM_SUM",		5, false,	__checksum_sum,	0, true},
 	{"()CSV",				5, false,	__csv},
 	{"()XML",				4, false,	__xml},
 	{"()XML_ATTR",			2, false,	__xml_attr},
 	{"()XML_SAVE_CONTEXT",	0, false,	__xml_save_context},
 	{"()XML_RESTORE_CONTEXT",0,false,	__xml_restore_context},
 	{"()TEXT_TABLE",		2, false,	__text_table},
-	{"()SHA1",				1, false,	__sha1},
-	{"()DW_ENCODE",			1, false,	__dw_encode},
-	{"()DW_DECODE",			1, false,	__dw_decode},
-	{"()CRC_16",			1, false,	__crc_16},
+	{"()SHA1",				1, false,	__sha1,			0, true},
+	{"()DW_ENCODE",			1, false,	__dw_encode,	0, true},
+	{"()DW_DECODE",			1, false,	__dw_decode,	0, true},
+	{"()CRC_16",			1, false,	__crc_16,		0, true},
 
 	{"()NOW",				0, false,	__now},
 	{"()TIME_SET",			1, false,	__time_set},
-	{"()MKTIME",			2, false,	__mktime},
+	{"()MKTIME",			2, false,	__mktime,		0, true},
 	{"()TIME",				2, false,	__time},
-	{"()LEAP_ADJ",			1, false,	__leap_adj},
+	{"()LEAP_ADJ",			1, false,	__leap_adj,		0, true},
 	{"()SLEEP",				1, false,	__sleep},
 	{"()TIMER_START",		0, false,	__timer_start},
 	{"()TIMER_STOP",		0, false,	__timer_stop},
 
-	{"()MUL",				2, false,	__math},
-	{"()DIV",				2, false,	__math},
-	{"()MOD",				2, false,	__math},
-	{"()SUM",				2, false,	__math},
-	{"()SUB",				2, false,	__math},
+	{"()MUL",				2, false,	__math,			C_OP_MUL, true},
+	{"()DIV",				2, false,	__math,			C_OP_DIV, true},
+	{"()MOD",				2, false,	__math,			C_OP_MOD, true},
+	{"()SUM",				2, false,	__math,			C_OP_SUM, true},
+	{"()SUB",				2, false,	__math,			C_OP_SUB, true},
 	{"()RAND",				0, false,	__rand},
-	{"()LUHN",				1, false,	__luhn},
-	{"()FMT",				2, false,	__fmt},
-	{"()AMOUNT",			2, false,	__amount},
-	{"()LEN",				1, false,	__len},
+	{"()LUHN",				1, false,	__luhn,			0, true},
+	{"()FMT",				2, false,	__fmt,			0, true},
+	{"()AMOUNT",			2, false,	__amount,		0, true},
+	{"()LEN",				1, false,	__len,			0, true},
 
 	{"()LOCATE",			4, false,	__locate},
 	{"()MAP_TABLE",			3, false,	__map_table},
@@ -93,11 +93,12 @@ const T_IRIS_FUNC irisFunc[C_NO_OF_IRIS_FUNCTIONS] =
 	{"()UPLOAD_OBJ",		1, false,	__upload_obj},
 	{"()DOWNLOAD_OBJ",		1, false,	__download_obj},
 	{"()REMOTE",			0, false,	__remote},
+	{"()SYNC",				0, false,	__sync},
 	{"()PREV_OBJECT",		0, false,	__prev_object},
 	{"()NEXT_OBJECT",		0, false,	__next_object},
-	{"()CURR_OBJECT",		0, false,	__curr_object},
-	{"()CURR_VERSION",		0, false,	__curr_version},
-	{"()CURR_GROUP",		0, false,	__curr_group},
+	{"()CURR_OBJECT",		0, false,	__curr_object,	0, true},
+	{"()CURR_VERSION",		0, false,	__curr_version,	0, true},
+	{"()CURR_GROUP",		0, false,	__curr_group,	0, true},
 	{"()CURR_EVENT",		0, false,	__curr_event},
 	{"()CURR_EVENT_VALUE",	0, false,	__curr_event_value},
 	{"()NEW_EVENT_VALUE",	0, false,	__new_event_value},
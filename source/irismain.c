@@ -78,6 +78,23 @@ typedef struct
 T_MAP map[30];
 int mapIndex = 0;
 
+// The map entries indexed by the key and event bits they react to. Built by buildDispatch() once the PATH is processed.
+static uchar keyDispatch[32];		// First map entry (+1) reacting to each key bit
+static uchar evtDispatch[32];		// First map entry (+1) reacting to each event bit
+static uchar mapNext[30];			// Next map entry (+1) reacting to the same event
+static uchar keyIndex[256];			// key_string[] entry (+1) of each key code
+
+typedef struct
+{
+	T_DEPENDENCY dependency;	// What the animation element was last resolved from
+	bool current;				// The display still shows what the element resolves to while its dependencies are unchanged
+	ulong timeDelay;
+	bool largeFont;
+	bool placed;				// A redisplayed element was drawn at this row
+	int row;
+	bool graph;
+} T_ANIMATION;
+
 uchar track1Len;
 uchar track2Len;
 char track1[90];
@@ -147,6 +164,92 @@ bool vmacRefresh;
 
 static uchar iris_ktk1[17] = "\x43\x2B\x37\xD4\x64\xD7\xBF\x5C\x5D\xD2\x5D\xC5\xC2\x1D\x9B\xB8";
 
+//
+// Returns the bit number of a single bit bitmap or -1 if not a single bit
+//
+static int bitNumber(ulong bitmap)
+{
+	int i;
+
+	if (bitmap == 0 || (bitmap & (bitmap - 1)))
+		return -1;
+
+	for (i = 0; (bitmap & 1) == 0; i++, bitmap >>= 1);
+
+	return i;
+}
+
+//
+//-------------------------------------------------------------------------------------------
+// FUNCTION   : buildDispatch
+//
+// DESCRIPTION:	Index the map entries by the key and event bits they react to
+//
+// PARAMETERS:	None
+//
+// RETURNS:		None
+//-------------------------------------------------------------------------------------------
+//
+static void buildDispatch(void)
+{
+	int i, bit;
+
+	memset(keyDispatch, 0, sizeof(keyDispatch));
+	memset(evtDispatch, 0, sizeof(evtDispatch));
+	memset(mapNext, 0, sizeof(mapNext));
+
+	// Go backwards so the first entry in the PATH ends up first
+	for (i = mapIndex - 1; i >= 0; i--)
+	{
+		for (bit = 0; bit < 32; bit++)
+		{
+			if (map[i].keyBitmap & (1UL << bit))
+				keyDispatch[bit] = i + 1;
+		}
+
+		if ((bit = bitNumber(map[i].evtBitmap)) != -1)
+		{
+			mapNext[i] = evtDispatch[bit];
+			evtDispatch[bit] = i + 1;
+		}
+	}
+}
+
+//
+// Returns the first map entry that can react to the event. Unusual combinations are looked for through all the entries.
+//
+static int firstMapEntry(T_EVTBITMAP evtBitmap, uchar key, T_KEYBITMAP keyBitmap)
+{
+	int bit;
+	int first = mapIndex;
+
+	if (key != KEY_NONE)
+	{
+		for (bit = 0; keyBitmap && bit < 32; bit++)
+		{
+			if ((keyBitmap & (1UL << bit)) && keyDispatch[bit] && (keyDispatch[bit] - 1) < first)
+				first = keyDispatch[bit] - 1;
+		}
+		return first;
+	}
+
+	if (keyBitmap == KEY_NO_BITS && (bit = bitNumber(evtBitmap)) != -1)
+		return evtDispatch[bit]? (evtDispatch[bit] - 1):mapIndex;
+
+	return 0;
+}
+
+//
+// Returns the next map entry that can react to the event after entry i
+//
+static int nextMapEntry(int i, T_EVTBITMAP evtBitmap, uchar key, T_KEYBITMAP keyBitmap)
+{
+	if (key == KEY_NONE && keyBitmap == KEY_NO_BITS && bitNumber(evtBitmap) != -1)
+		return mapNext[i]? (mapNext[i] - 1):mapIndex;
+
+	return i + 1;
+}
+
 static bool processEvent2(T_EVTBITMAP evtBitmap, uchar key, T_KEYBITMAP keyBitmap, char * event)
 {
 	int i;
@@ -156,8 +259,8 @@ static bool processEvent2(T_EVTBITMAP evtBitmap, uchar key, T_KEYBITMAP keyBitma
 	// Set some information about terminal activity
 	UtilStrDup(&newEventValue, event);
 
-	// Check if an event has occurred
-	for (i = 0; i < mapIndex; i++)
+	// Check if an event has occurred. Only the map entries reacting to it are visited.
+	for (i = firstMapEntry(evtBitmap, key, keyBitmap); i < mapIndex; i = nextMapEntry(i, evtBitmap, key, keyBitmap))
 	{
 		if ((keyBitmap & map[i].keyBitmap) || (key == KEY_NONE && evtBitmap == map[i].evtBitmap))
 		{
@@ -252,17 +355,22 @@ char * getLastKeyDesc(unsigned char key, T_KEYBITMAP * keyBitmap)
 {
 	int i;
 
-	// Convert the key pressed to a bitmap
-	for (i = 0; key_string[i].event; i++)
+	// Index the key codes the first time around
+	if (keyIndex[KEY_NONE] == 0)
 	{
-		if (key == key_string[i].key)
+		for (i = 0; key_string[i].event; i++)
 		{
-			if (keyBitmap)
-				*keyBitmap = key_string[i].keyBitmap;
-			break;
+			if (keyIndex[key_string[i].key] == 0)
+				keyIndex[key_string[i].key] = i + 1;
 		}
+		keyIndex[KEY_NONE] = i + 1;
 	}
 
+	// Convert the key pressed to a bitmap
+	i = keyIndex[key]? (keyIndex[key] - 1):keyIndex[KEY_NONE] - 1;
+	if (keyBitmap && key_string[i].event)
+		*keyBitmap = key_string[i].keyBitmap;
+
 	return key_string[i].event;
 }
 
@@ -465,6 +573,128 @@ static void processPath(char * events, T_KEYBITMAP * keyBitmap, T_EVTBITMAP * ke
 	}
 }
 
+//
+// Returns true if a simple value is a constant object name rather than a reference or a function
+//
+static bool objectNameConstant(char * name)
+{
+	if (name[0] == '\0' || strchr("/~@(\\", name[0]) || strchr(name, '/') || strcmp(name, "__NO_ANIMATION") == 0 || strcmp(name, "THIS") == 0)
+		return false;
+
+	return true;
+}
+
+//
+//-------------------------------------------------------------------------------------------
+// FUNCTION   : prefetchValue
+//
+// DESCRIPTION:	Queue the objects a value may lead to for prefetching. Only constant names are
+//				followed. Values that are resolved at run time are left alone.
+//
+// PARAMETERS:	value	<=	The parsed value
+//				names	<=	If true, a simple value is an object name (eg. the next object of a PATH entry)
+//
+// RETURNS:		None
+//-------------------------------------------------------------------------------------------
+//
+static void prefetchValue(char * value, bool names)
+{
+	char ** array;
+
+	if (value == NULL)
+		return;
+
+	if (value[0] == 0)
+	{
+		if (names && objectNameConstant(&value[4]))
+			IRIS_PrefetchObject(&value[4]);
+		return;
+	}
+
+	array = (char **) &value[4];
+
+	// An implicit concatenation. The only object names in there are the tables given to the table functions.
+	if (*array && (*array)[0] == 0)
+	{
+		for (; *array; array++)
+		{
+			if ((*array)[0] == 0 && (strcmp(&(*array)[4], "()TEXT_TABLE") == 0 || strcmp(&(*array)[4], "()MAP_TABLE") == 0))
+			{
+				if (array[1] && array[1][0] == 0)
+					prefetchValue(array[1], true);
+			}
+			else if ((*array)[0] == 1)
+				prefetchValue(*array, false);
+		}
+		return;
+	}
+
+	// A condition. Follow the value pushed by each condition and the default value
+	for (; *array; array++)
+	{
+		char ** condition = (char **) &(*array)[4];
+
+		if ((*array)[0] == 0)
+			prefetchValue(*array, names);
+		else if (condition[0] && condition[1] && condition[2] && condition[3])
+			prefetchValue(condition[3], names);
+	}
+}
+
+//
+// Queue the objects the values of an action object may lead to for prefetching
+//
+static void prefetchAction(char * action)
+{
+	int position = 0;
+	int size;
+	char name[50];
+	char * value;
+
+	if (action == NULL)
+		return;
+
+	for (size = strlen(action); (value = IRIS_NextStringValue(action, size, &position, name, sizeof(name))) != NULL; IRIS_DeallocateStringValue(value))
+		prefetchValue(value, false);
+}
+
+//
+// Queue the missing objects the current display object may lead to. They are fetched in one go once the screen is displayed.
+//
+static void prefetchObjects(char * animation)
+{
+	int i;
+
+	// The next objects and the tables used by the actions of the PATH
+	for (i = 0; i < mapIndex; i++)
+	{
+		prefetchValue(map[i].object, true);
+		prefetchAction(map[i].action);
+	}
+
+	// The text tables and images displayed
+	if (animation && animation[0] == 1)
+	{
+		char ** array1 = (char **) &animation[4];
+
+		for (; *array1; array1++)
+		{
+			char ** array2 = (char **) &(*array1)[4];
+
+			if ((*array1)[0] != 1 || array2[0] == NULL || array2[0][0] != 0 || array2[1] == NULL)
+				continue;
+
+			if (strcmp(&array2[0][4], "GRAPH") == 0)
+			{
+				if (array2[2])
+					prefetchValue(array2[2], true);
+			}
+			else if (strcmp(&array2[0][4], "TEXT") == 0 || strcmp(&array2[0][4], "INV") == 0 || strcmp(&array2[0][4], "LARGE") == 0 || strcmp(&array2[0][4], "LINV") == 0)
+				prefetchValue(array2[1], true);
+		}
+	}
+}
+
 //
 //-------------------------------------------------------------------------------------------
 // FUNCTION   : processDisplayObject2
@@ -496,6 +726,7 @@ static void processDisplayObject2(void)
 	bool nonPermanent = false;
 	bool dispCleared = false;
 	bool reDisplay[50];
+	T_ANIMATION animationState[50];
 
 	// After lots os trial and error, I found the Verifone terminal to benefit significanty in speed if I
 	// clear the latest text table prior to displaying the IDLE screen. Visiting another VAA will also do,
@@ -513,9 +744,14 @@ static void processDisplayObject2(void)
 //		}
 //	}
 
+	// Fold the journalled permanent data updates back into their objects while idle
+	if (strcmp(currentObject, "IDLE") == 0)
+		IRIS_CompactObjectJournal(NULL);
+
 	// Initialisation
 	animationOK = true;
 	memset(reDisplay, 0, sizeof(reDisplay));
+	memset(animationState, 0, sizeof(animationState));
 	memset(track1, 0, sizeof(track1));
 	memset(track2, 0, sizeof(track2));
 	track1Len = 80;
@@ -605,8 +841,9 @@ static void processDisplayObject2(void)
 	IRIS_StackPop(1);
 
 	// Look for events to process
-	events = IRIS_GetStringValue(currentObjectData, currentObjectLength, "PATH", false);
+	events = IRIS_GetParsedStringValue(currentObjectData, currentObjectLength, "PATH");
 	processPath(events, &keyBitmap, &keepEvtBitmap);
+	buildDispatch();
 
 	// Check for INIT0 events now and perform any initial actions now
 	if (strcmp(prevObject,currentObject))
@@ -618,13 +855,17 @@ static void processDisplayObject2(void)
 
 	// Get the value of the animation string from the display object
 	if (animationOK)
-		animation = IRIS_GetStringValue(currentObjectData, currentObjectLength, "ANIMATION", false);
+		animation = IRIS_GetParsedStringValue(currentObjectData, currentObjectLength, "ANIMATION");
 	else
 	{
 		flush = false;
 		animation = NULL;
 	}
 
+	// Look for the missing objects this display may lead to
+	if (eventOccurred == false)
+		prefetchObjects(animation);
+
 /*																		{
 																			char tempBuf[40];
 																			sprintf(tempBuf, "Object Start 2 ");
@@ -665,8 +906,19 @@ static void processDisplayObject2(void)
 					char * value;
 					bool skipDisplay = false;
 					bool hidden = false;
+					bool evaluate;
 
-					for(index = 0; *array2; array2++, index++)
+					// An element still showing what it resolves to is not resolved or displayed again. Only its time delay is waited for.
+					evaluate = (bool) (firstRound || !animationState[i].current || IRIS_DependencyChanged(&animationState[i].dependency));
+					if (evaluate)
+						IRIS_TrackDependencies(&animationState[i].dependency);
+					else
+					{
+						timeDelay = animationState[i].timeDelay;
+						largeFont = animationState[i].largeFont;
+					}
+
+					for(index = 0; evaluate && *array2; array2++, index++)
 					{
 
 						IRIS_ResolveToSingleValue(*array2, false);
@@ -993,8 +1245,31 @@ static void processDisplayObject2(void)
 						IRIS_StackPop(stackIndex - myStackIndex);
 					}
 
+					if (evaluate)
+					{
+						int j;
+
+						IRIS_TrackDependencies(NULL);
+
+						// Erased and counted displays change on their own and so do the battery and signal levels
+						animationState[i].current = (bool) (erase == NULL && displayLoopEnd == 0 && inputMaxLength == 0 && operation != 2 && operation != 3);
+						animationState[i].timeDelay = timeDelay;
+						animationState[i].largeFont = largeFont;
+						animationState[i].placed = (bool) (reDisplay[i] && inputMaxLength == 0);
+						animationState[i].row = row;
+						animationState[i].graph = (bool) (operation == 1);
+
+						// Redisplayed elements sharing a row draw over each other in turn so neither can be left as it is.
+						// The area of a graphic is not known so it is taken to overlap every other element.
+						for (j = 0; animationState[i].placed && j < 50; j++)
+						{
+							if (j != i && animationState[j].placed && (animationState[j].row == row || animationState[j].graph || operation == 1))
+								animationState[i].current = animationState[j].current = false;
+						}
+					}
+
 					// If we have not reached the end of the loop for non-permanent displays, do not display yet
-					if (reDisplay[i] && displayYes == false)
+					if ((reDisplay[i] && displayYes == false) || evaluate == false)
 						skipDisplay = true;
 
 					// Input definitions do not have any associated displays
@@ -1176,14 +1451,18 @@ static void processDisplayObject2(void)
 
 			eventOccurred = processEvent(keepEvtBitmap | (nonPermanent?EVT_TIMEOUT:EVT_NONE), keyBitmap, inpEntry, displayTimeout, (bool) (displayTimeoutMultiplier > 1? true:false), inpLargeFont, &flush);
 			if (displayTimeoutMultiplier) displayTimeoutMultiplier--;
+
+			// Once the screen has been left waiting without a key press, get the missing objects in one go rather than one at a time when they are needed
+			if (eventOccurred == false && lastKey == KEY_NONE && inpEntry.type == E_INP_NO_ENTRY)
+				IRIS_PrefetchObjects();
 		}
 	}
 
-	// Deallocate the animation object used during this display
-	IRIS_DeallocateStringValue(animation);
+	// Release the animation object used during this display
+	IRIS_ReleaseStringValue(currentObjectData, currentObjectLength, "ANIMATION", animation);
 
-	// Deallocate the event object
-	IRIS_DeallocateStringValue(events);
+	// Release the event object
+	IRIS_ReleaseStringValue(currentObjectData, currentObjectLength, "PATH", events);
 }
 
 //
@@ -1205,7 +1484,7 @@ static void processDisplayObject2(void)
 static void processDisplayObject()
 {
 	// Get the object
-	if ((currentObjectData = IRIS_GetObjectData(currentObject, &currentObjectLength)) == NULL)
+	if ((currentObjectData = IRIS_LockObjectData(currentObject, &currentObjectLength)) == NULL)
 	{
 		if (++getObjectAgain >= 2)
 		{
@@ -1243,7 +1522,8 @@ static void processDisplayObject()
 	processDisplayObject2();
 
 	// House keep and finish
-	UtilStrDup(&currentObjectData, NULL);
+	IRIS_UnlockObjectData(currentObjectData);
+	currentObjectData = NULL;
 }
 
 static void processObjectLoop()
@@ -1349,6 +1629,7 @@ void executeCallbackObjects(char * callbackObject)
 
 	mapIndex = preserve_mapIndex;
 	memcpy(map, preserve_map, sizeof(map));
+	buildDispatch();
 
 	displayTimeout = preserve_displayTimeout;
 	displayTimeoutMultiplier = preserve_displayTimeoutMultiplier;
@@ -1435,6 +1716,9 @@ main(int argc, char * argv[])
 	VMACLoop();
 #endif
 
+	// Complete any permanent data updates interrupted by a power failure
+	IRIS_RecoverBatch();
+
 	// Perform an initial object check to guard against tamper...
 	IRIS_StackInit(0);
 
@@ -1443,7 +1727,7 @@ main(int argc, char * argv[])
 	{
 		IRIS_StackPushFunc("()OBJECTS_CHECK");	// Called here instead of an object since all objects are not authentic yet..so we have to use the program
 		IRIS_StackPush("51");					// The Secure Key location..Hardcoded for security reasons against tamper of "iRIS" object
-		IRIS_StackPush(NULL);					// Check all objects
+		IRIS_StackPush("I");					// Only check the objects changed since the last check and a sample of the others
 	}
 
 	processObjectLoop();
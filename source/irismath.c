@@ -84,36 +84,34 @@ static int attrEnd;
 void __math(void)
 {
 	long res = 0;
-	char result[30];
-	long f = 0;
-	long s = 0;
-
-	// Obtain the first value if available
-	if (IRIS_StackGet(1))
-		f = atol(IRIS_StackGet(1));
-
-	// Obtain the second value if available
-	if (IRIS_StackGet(0))
-		s = atol(IRIS_StackGet(0));
+	long f = IRIS_StackGetNumber(1);
+	long s = IRIS_StackGetNumber(0);
 
 	// Perform the appropriate operation
-	if (strcmp(IRIS_StackGet(2), "()MUL") == 0)
-		res = f * s;
-	else if (strcmp(IRIS_StackGet(2), "()DIV") == 0 && s)
-		res = f / s;
-	else if (strcmp(IRIS_StackGet(2), "()MOD") == 0 && s)
-		res = f % s;
-	else if (strcmp(IRIS_StackGet(2), "()SUM") == 0)
-		res = f + s;
-	else if (strcmp(IRIS_StackGet(2), "()SUB") == 0)
-		res = f - s;
+	switch (IRIS_FuncOp())
+	{
+		case C_OP_MUL:
+			res = f * s;
+			break;
+		case C_OP_DIV:
+			if (s) res = f / s;
+			break;
+		case C_OP_MOD:
+			if (s) res = f % s;
+			break;
+		case C_OP_SUM:
+			res = f + s;
+			break;
+		case C_OP_SUB:
+			res = f - s;
+			break;
+	}
 
 	// Lose the function and parameters
 	IRIS_StackPop(3);
 
-	// Make the result a string and push back onto the stack
-	sprintf(result, "%ld", res);
-	IRIS_StackPush(result);
+	// Push the result back onto the stack. It only becomes a string if someone needs it as one
+	IRIS_StackPushNumber(res);
 }
 
 //
@@ -174,7 +172,7 @@ void __luhn(void)
 	if (luhn%10 || !pan)
 		IRIS_StackPush(NULL);
 	else
-		IRIS_StackPush("TRUE");
+		IRIS_StackPushConst("TRUE");
 }
 
 //
@@ -240,7 +238,7 @@ void __amount(void)
 	strcpy(&result[4], "/IRIS_CURRENCY/DECIMAL");
 	IRIS_ResolveToSingleValue(result, false);
 	if (IRIS_StackGet(0))
-		curr_decimal = atoi(IRIS_StackGet(0));
+		curr_decimal = IRIS_StackGetNumber(0);
 	else curr_decimal = 2;
 	IRIS_StackPop(1);
 
@@ -304,21 +302,11 @@ void __amount(void)
 void __len(void)
 {
 	char * value = IRIS_StackGet(0);
+	int length = value? strlen(value):0;
 
-	if (value)
-	{
-		char temp[10];
-		int length = strlen(value);
-		
-		// Clean up and return NULL if value does not exist
-		IRIS_StackPop(2);
-		IRIS_StackPush(ltoa(length, temp, 10));
-		return;
-	}
-
-	// Clean up and return NULL if value does not exist
+	// Clean up and return 0 if value does not exist
 	IRIS_StackPop(2);
-	IRIS_StackPush("0");
+	IRIS_StackPushNumber(length);
 }
 
 //
@@ -525,31 +513,23 @@ void __substring(void)
 //
 // DESCRIPTION:	Calculates SHA1 of the supplied buffer
 //
-// PARAMETERS:	Assumes input is an ASCII hex.
+// PARAMETERS:	Assumes input is a byte array or ASCII hex.
 //				If normal ASCII characters, the caller must convert it first by using "\h"
 //
-// RETURNS:		SHA1 (20 hex bytes = 40 ASCII bytes)
+// RETURNS:		SHA1 (20 hex bytes that read as 40 ASCII bytes)
 //-------------------------------------------------------------------------------------------
 //
 void __sha1(void)
 {
 	sha1_context sha1;
 	uchar hexDigest[20];
-	char digest[41];
-
-	uchar * hex;
+	uint size;
 
-	// Get the data that we need to SHA1 in ASCII from the stack
-	char * data = IRIS_StackGet(0);
+	// Get the data that we need to SHA1 from the stack
+	uchar * hex = (uchar *) IRIS_StackGetBytes(0, &size);
 
-	if (data)
+	if (hex)
 	{
-		int size = strlen(data) / 2;
-
-		// Allocate enough hex buffer and convert the ASCII hex data to hex.
-		hex = my_malloc(size+1);
-		size = UtilStringToHex(data, strlen(data), hex);
-
 		// Perform sha-1
 		sha1_starts(&sha1);
 		sha1_update(&sha1, hex, size);
@@ -557,12 +537,9 @@ void __sha1(void)
 
 		// Lose the function name and data
 		IRIS_StackPop(2);
-		my_free(hex);
-
-		// Change digest to ASCII hex and return it
-		UtilHexToString(hexDigest, sizeof(hexDigest), digest);
 
-		IRIS_StackPush(digest);
+		// Return the digest. It reads as ASCII hex
+		IRIS_StackPushBlob((char *) hexDigest, sizeof(hexDigest));
 	}
 	else
 	{
@@ -620,17 +597,17 @@ void __to_ascii_hex(void)
 //
 void __to_hex(void)
 {
-	char * ascii_hex = IRIS_StackGet(0);
-	uchar * hex; 
+	uint length;
+	char * hex = IRIS_StackGetBytes(0, &length);
 
-	if (ascii_hex)
+	if (hex)
 	{
-		hex = my_calloc(strlen(ascii_hex) / 2 + 1);
-		UtilStringToHex(ascii_hex, strlen(ascii_hex), hex);
+		// The bytes belong to the stack so keep a copy for after the pop
+		hex = strcpy(my_malloc(strlen(hex) + 1), hex);
 
 		IRIS_StackPop(2);
 
-		IRIS_StackPush((char *) hex);
+		IRIS_StackPush(hex);
 		my_free(hex);
 	}
 	else
@@ -325,7 +325,7 @@ void __ser_data(void)
 	IRIS_StackPop(2);
 
 	if (myComms->wHandle != 0xFFFF && Comms(myPort == 0?E_COMMS_FUNC_SERIAL_DATA_AVAILABLE:E_COMMS_FUNC_SERIAL2_DATA_AVAILABLE, myComms) == 1)
-		IRIS_StackPush("TRUE");
+		IRIS_StackPushConst("TRUE");
 	else
 		IRIS_StackPush(NULL);
 }
@@ -46,6 +46,8 @@
 // Constants
 //-----------------------------------------------------------------------------
 //
+#define	C_LINGER			60		// Default seconds an idle connection is kept open for the next session
+#define	C_SESSION_TIMEOUT	60		// Seconds a connection in use is kept open without any activity
 
 //
 //-----------------------------------------------------------------------------
@@ -63,7 +65,10 @@ static char currPDNS[50];
 static char currSDNS[50];
 static char currIPAddress[50];
 static unsigned int currPortNumber;
+static E_HEADER currHeader;
 static unsigned int currHandle;
+static unsigned int linger = C_LINGER;
+static bool inSession = false;
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -177,6 +182,15 @@ void __tcp_connect(void)
 	char * oip = IRIS_StackGet(8);	// This is also "APN" for GPRS connections
 	char * header = IRIS_StackGet(9);
 	bool change = false;
+	char buffer[10];
+
+	// The linger time can be changed via the environment at any time. Zero disconnects at the end of each session
+	if (get_env("#LINGER", buffer, sizeof(buffer) - 1) > 0)
+	{
+		buffer[sizeof(buffer) - 1] = '\0';
+		linger = atoi(buffer);
+	}
+	else linger = C_LINGER;
 
 	// Set the communication structure...
 	memset(&comms, 0, sizeof(comms));
@@ -184,6 +198,7 @@ void __tcp_connect(void)
 	comms.eConnectionType = E_CONNECTION_TYPE_IP;
 	if (header && header[0] >= '1' && header[0] <= '5')
 		comms.eHeader = header[0] - '0';
+	if (comms.eHeader != currHeader) change = true;
 
 	// Set the connection timeout
 	if (timeout && timeout[0])
@@ -262,11 +277,15 @@ void __tcp_connect(void)
 			retVal = Comms(E_COMMS_FUNC_CONNECT, &comms);
 		}
 
-		// If no change, report all is connected OK.
+		// If no change, reuse the connection if it is still up. Otherwise, connect again
 		else
 		{
-			retVal = ERR_COMMS_NONE;
 			comms.wHandle = currHandle;
+			if ((retVal = Comms(E_COMMS_FUNC_IDLE_CHECK, &comms)) != ERR_COMMS_NONE)
+			{
+				__tcp_disconnect_do();
+				retVal = Comms(E_COMMS_FUNC_CONNECT, &comms);
+			}
 		}
 	}
 	// Initiate the connection
@@ -283,13 +302,15 @@ void __tcp_connect(void)
 	// Arm the timer
 	if (retVal == ERR_COMMS_NONE)
 	{
-		myTime = my_time(NULL) + 60;
+		myTime = my_time(NULL) + C_SESSION_TIMEOUT;
+		inSession = true;
 		strcpy(currOwnIPAddress, comms.ownIpAddress);
 		strcpy(currGateway, comms.gateway);
 		strcpy(currPDNS, comms.pdns);
 		strcpy(currSDNS, comms.sdns);
 		strcpy(currIPAddress, comms.ipAddress);
 		currPortNumber = comms.wPortNumber;
+		currHeader = comms.eHeader;
 		currHandle = comms.wHandle;
 	}
 
@@ -359,8 +380,11 @@ void __tcp_disconnect(void)
 //#endif
 		__tcp_disconnect_do();
 
-	// Delay the connection for one minute
-	else myTime = my_time(NULL) + 60;
+	// Keep the connection open for the next session unless lingering is disabled
+	else if (linger == 0)
+		__tcp_disconnect_do();
+	else myTime = my_time(NULL) + linger;
+	inSession = false;
 
 #ifdef __VX670
 	comms.fFastConnect = true;
@@ -402,6 +426,7 @@ void __tcp_disconnect_do(void)
 {
 	Comms(E_COMMS_FUNC_DISCONNECT, &comms);
 	myTime = 0xFFFFFFFFUL;
+	inSession = false;
 
 /*	currPortNumber = 0;
 	if (comms.fFastConnect == false)
@@ -485,8 +510,9 @@ void __tcp_disconnect_check(void)
 //
 void __tcp_disconnect_extend(void)
 {
+	// An idle connection kept for the next session only lingers for the configured time
 	if (currHandle != 0xFFFF)
-		myTime = my_time(NULL) + 60;
+		myTime = my_time(NULL) + (inSession? C_SESSION_TIMEOUT:linger);
 }
 
 //
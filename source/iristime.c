@@ -365,8 +365,6 @@ void __sleep(void)
 //
 void __timer_start(void)
 {
-	char temp[20];
-
 #ifdef _DEBUG
 	ticks = 0;
 #else
@@ -374,7 +372,7 @@ void __timer_start(void)
 #endif
 
 	IRIS_StackPop(1);
-	IRIS_StackPush(ltoa(ticks, temp, 10));
+	IRIS_StackPushNumber(ticks);
 }
 
 //
@@ -390,8 +388,6 @@ void __timer_start(void)
 //
 void __timer_stop(void)
 {
-	char temp[20];
-
 #ifdef _DEBUG
 	unsigned long diff = 2;
 #else
@@ -405,6 +401,6 @@ void __timer_stop(void)
 #endif
 
 	IRIS_StackPop(1);
-	IRIS_StackPush(ltoa(diff, temp, 10));
+	IRIS_StackPushNumber(diff);
 }
 
@@ -58,6 +58,8 @@
 // Constants
 //-----------------------------------------------------------------------------
 //
+#define	C_INFLATE_CHUNK		2048	// Minimum room made in the object window before inflating more
+#define	C_LEDGER_SAMPLE		8		// One in this many unchanged objects has its data checked again by an incremental check
 
 //
 //-----------------------------------------------------------------------------
@@ -507,7 +509,6 @@ void __new_object(void)
 	char * table = IRIS_StackGet(0);
 	char * objectName = IRIS_StackGet(1);
 	int count = 0;
-	char temp[10];
 
 	if (table && objectName)
 	{
@@ -611,24 +612,8 @@ void __new_object(void)
 					// We have dealt with all the arrays within the main array, now create the new object.
 					if (myObject && newObjectName)
 					{
-#ifdef _DEBUG
-						FILE * fp = fopen(newObjectName, "w+b");
-
-						if (fp)
-						{
-							strcat(myObject, "}");
-							fwrite(myObject, strlen(myObject), 1, fp);
-							fclose(fp);
-						}
-#else
-						int handle = open(newObjectName, O_CREAT | O_TRUNC | O_WRONLY | O_APPEND);
-						if (handle != -1)
-						{
-							strcat(myObject, "}");
-							write(handle, myObject, strlen(myObject));
-							close(handle);
-						}
-#endif
+						strcat(myObject, "}");
+						IRIS_PutNamedObjectData(myObject, strlen(myObject), newObjectName);
 					}
 
 					UtilStrDup(&myObject, NULL);
@@ -644,7 +629,7 @@ void __new_object(void)
 	IRIS_StackPop(3);
 
 	// Push the number of "string:value" elements added to the new object excluding the type and group that are added automatically
-	IRIS_StackPush(ltoa(count, temp, 10));
+	IRIS_StackPushNumber(count);
 }
 
 
@@ -654,7 +639,10 @@ void __new_object(void)
 //
 // DESCRIPTION:	Examine all the objects for authenticity and remove if not
 //
-// PARAMETERS:	None
+// PARAMETERS:	sk		<=	The location of the iRIS secret key
+//				onlyOne	<=	"1" to stop at the first object removed. "I" to only check the objects
+//							changed since the last check plus a rolling sample of the others.
+//							Otherwise, all objects are checked
 //
 // RETURNS:		None
 //-------------------------------------------------------------------------------------------
@@ -675,6 +663,9 @@ void __objects_check(void)
 	char * ptr;
 	bool erase = false;
 	int count = 0;
+	bool incremental = (onlyOne && onlyOne[0] == 'I');
+	int sample = (int) (read_ticks() % C_LEDGER_SAMPLE);
+	int objects = 0;
 
 	// Initialisation
 	DispInit();
@@ -683,6 +674,9 @@ void __objects_check(void)
 	lastFaultyFileName[0] = '\0';
 	lastFaultyGroup[0] = '\0';
 
+	// The ledger of the objects verified by the last check is only needed by an incremental check
+	IRIS_LedgerOpen(incremental?sk:NULL);
+
 	for (i = dir_get_first(fileName); i == 0; i = dir_get_next(fileName))
 	{
 #ifdef __VMAC
@@ -693,48 +687,27 @@ void __objects_check(void)
 			if ((++count % 10) == 0) DispText(".", 9999, 0, false, false, false);
 		}
 
-		if ((data = IRIS_GetObjectData(fileName, &length)) != NULL)
+		// Skip the objects that have not changed since verified, except for a different sample each time
+		if (incremental && (objects++ % C_LEDGER_SAMPLE) != sample && IRIS_LedgerVerified(fileName, NULL, 0))
+		{
+			strcpy(oldFileName, fileName);
+			continue;
+		}
+
+		if ((data = IRIS_LoadObjectData(fileName, &length)) != NULL)
 		{
 			if	(	data[0] == '{' && strstr(data, "NAME:") != NULL &&
 					((ptr = strstr(data, search1)) != NULL || (ptr = strstr(data, search2)) != NULL || (ptr = strstr(data, search3)) != NULL || (ptr = strstr(data, search4)) != NULL) &&
 					(ptr[-1] == ',' || ptr[-1] == '{')
 				)
 			{
-				// If signature does not exist, disacard objects
-				if ((ptr = strstr(data, "SIGN:")) != NULL)
-				{
-					char *ptrtmp;
-					char sign[40];
-					int myStackIndex = stackIndex;
-					stackLevel++;
-
-					// Replace signature with ZEROS keeping it safe.
-					memcpy(sign, ptr+5, sizeof(sign));
-					memcpy(ptr+5, "0000000000000000000000000000000000000000", sizeof(sign));
-
-					// Encrypt using iRIS secret key
-					SecuritySetIV(NULL);
-					IRIS_StackPushFunc("()ENC");
-					IRIS_StackPush(sk);			// Key location
-					IRIS_StackPush(NULL);		// 16 byte double length
-
-					// Calculate SHA-1. Result is the data for encryption
-					IRIS_StackPushFunc("()SHA1");
-					IRIS_StackPushFunc("()TO_AHEX");
-					IRIS_StackPush(data);
-
+				// If the signature does not exist or does not match, discard the object
+				if (strstr(data, "SIGN:") == NULL)
+					erase = true;
 #ifndef __UNSIGNED
-					// If SHA-1 does match, all OK
-					if (memcmp(IRIS_StackGet(0), sign, sizeof(sign))) {
-						erase = true;
-					}
+				else if ((incremental == false || IRIS_LedgerVerified(fileName, data, length) == false) && IRIS_VerifyObjectSignature(data, length, sk) == false)
+					erase = true;
 #endif
-
-					// House keep
-					IRIS_StackPop(stackIndex - myStackIndex);
-					stackLevel--;
-				}
-				else erase = true;
 			}
 				
 			// If we are to erase the object, go ahead
@@ -744,7 +717,7 @@ void __objects_check(void)
 
 				// Erase the file
 				DebugDisp("wrong sign:%s", fileName);
-				_remove(fileName); //TESTING
+				IRIS_RemoveObject(fileName); //TESTING
 				if (onlyOne == NULL || onlyOne[0] != '1')
 					DispText("*", 9999, 0, false, false, false);
 				
@@ -760,7 +733,11 @@ void __objects_check(void)
 				// House keep
 				strcpy(fileName, oldFileName);
 			}
-			else strcpy(oldFileName, fileName);
+			else
+			{
+				IRIS_LedgerRecord(fileName, data, length);
+				strcpy(oldFileName, fileName);
+			}
 
 			// Lose the object Data. Not needed any longer
 			UtilStrDup(&data, NULL);
@@ -774,6 +751,9 @@ void __objects_check(void)
 		}
 	}
 
+	// Keep the objects found authentic for the next incremental check
+	IRIS_LedgerClose(sk);
+
 	// Lose the parameters and function name
 	IRIS_StackPop(3);
 
@@ -824,61 +804,7 @@ void __faulty_group(void)
 }
 
 //
-//-------------------------------------------------------------------------------------------
-// FUNCTION   : ()DECOMPRESS
-//
-// DESCRIPTION:	Decompress the data supplied, frees it and returns an uncompressed buffer
-//
-// PARAMETERS:	None
-//
-// RETURNS:		None
-//-------------------------------------------------------------------------------------------
-//
-static unsigned char * decompress(unsigned char * input, unsigned long outSize, unsigned long size)
-{
-	unsigned char * output;
-	z_stream d_stream;
-	int err;
-
-	// Allocate an output buffer
-	output = my_malloc(outSize+50);	// Extra memory just in case the decompression uses more memory becuase of a fault
-
-	// Initialisation
-	memset(&d_stream, 0, sizeof(d_stream));
-	d_stream.next_in = input;
-	d_stream.next_out = output;
-	d_stream.zalloc = (alloc_func)0;
-	d_stream.zfree = (free_func)0;
-	d_stream.opaque = (voidpf)0;
-	d_stream.avail_in = 0;
-	err = inflateInit(&d_stream);
-
-	// Process the compressed stream
-	while (d_stream.total_in < size)
-	{
-		d_stream.avail_in = d_stream.avail_out = 1; /* force small buffers */
-		err = inflate(&d_stream, Z_NO_FLUSH);
-		if (err == Z_STREAM_END) break;
-		if (err != Z_OK) break;
-	}
-
-	// Finalise the decompression
-	err = inflateEnd(&d_stream);
-
-	// Return the uncompressed output
-	return output;
-}
-
-//
-//-------------------------------------------------------------------------------------------
-// FUNCTION   : ()STORE_OBJECTS
-//
-// DESCRIPTION:	A privilaged function. It can only be used by the iRIS group
-//
-// PARAMETERS:	None
-//
-// RETURNS:		None
-//-------------------------------------------------------------------------------------------
+// Frame the next JSON object starting at objects[*index]. Leading bytes that are not part of an object are skipped
 //
 static uint getNextObject(char * objects, uint * index, uint objectsLength)
 {
@@ -917,25 +843,118 @@ static uint getNextObject(char * objects, uint * index, uint objectsLength)
 		}
 	}
 
-	if (length)
+	// An object cut short by the end of the data is not complete yet
+	if (length && marker == 0)
 		return length;
 
 	return 0;
 }
 
+//
+// A compressed object bundle is inflated into a window that only holds the object being framed.
+// Objects already handed out are dropped from the window so memory is bounded by the largest object.
+//
+typedef struct
+{
+	z_stream d_stream;
+	char * window;		// Decompressed data not handed out yet. Always null terminated
+	uint length;		// Number of bytes held in the window
+	uint size;			// Allocated size of the window
+	bool end;			// No more data can be inflated
+} T_OBJECT_STREAM;
+
+static void streamStart(T_OBJECT_STREAM * stream, unsigned char * input, unsigned long size)
+{
+	memset(stream, 0, sizeof(T_OBJECT_STREAM));
+	stream->d_stream.next_in = input;
+	stream->d_stream.avail_in = size;
+	stream->d_stream.zalloc = (alloc_func)0;
+	stream->d_stream.zfree = (free_func)0;
+	stream->d_stream.opaque = (voidpf)0;
+	stream->size = C_INFLATE_CHUNK;
+	stream->window = my_malloc(stream->size);
+	stream->window[0] = '\0';
+
+	if (inflateInit(&stream->d_stream) != Z_OK)
+		stream->end = true;
+}
+
+// Inflate as much as the room left in the window allows. The window doubles when it runs short of room
+static void streamInflate(T_OBJECT_STREAM * stream)
+{
+	uint room;
+
+	if (stream->size - stream->length - 1 < C_INFLATE_CHUNK)
+	{
+		stream->size *= 2;
+		stream->window = my_realloc(stream->window, stream->size);
+	}
+
+	room = stream->size - stream->length - 1;
+	stream->d_stream.next_out = (Bytef *) &stream->window[stream->length];
+	stream->d_stream.avail_out = room;
+
+	// Anything but Z_OK is the end of the stream, a fault or no progress possible
+	if (inflate(&stream->d_stream, Z_NO_FLUSH) != Z_OK)
+		stream->end = true;
+
+	stream->length += room - stream->d_stream.avail_out;
+	stream->window[stream->length] = '\0';
+}
+
+// Returns the length of the next complete object at window[*index] or 0 when there are no more
+static uint streamNextObject(T_OBJECT_STREAM * stream, uint * index)
+{
+	uint length;
+
+	for (;;)
+	{
+		// Drop what has been handed out or skipped already
+		if (*index)
+		{
+			stream->length -= *index;
+			memmove(stream->window, &stream->window[*index], stream->length + 1);
+			*index = 0;
+		}
+
+		if ((length = getNextObject(stream->window, index, stream->length)) != 0 || stream->end)
+			return length;
+
+		streamInflate(stream);
+	}
+}
+
+static void streamStop(T_OBJECT_STREAM * stream)
+{
+	inflateEnd(&stream->d_stream);
+	my_free(stream->window);
+}
+
+//
+//-------------------------------------------------------------------------------------------
+// FUNCTION   : ()STORE_OBJECTS
+//
+// DESCRIPTION:	A privilaged function. It can only be used by the iRIS group
+//
+// PARAMETERS:	None
+//
+// RETURNS:		None
+//-------------------------------------------------------------------------------------------
+//
 void __store_objects(void)
 {
 	uint index;
 	uint count = 0;
 	char temp[10];
-	char * objects = IRIS_StackGet(0);
+	uint size;
+	char * objects_hex = IRIS_StackGetBytes(0, &size);
+	char * objects;
 	char * sk = IRIS_StackGet(1);
 	uint length;
-	unsigned long size, outSize;
-	char * objects_hex;
+	T_OBJECT_STREAM stream;
 
 	// Handle null errors
-	if (!sk || !objects || strcmp(currentObjectGroup, irisGroup))
+	if (!sk || !objects_hex || size < 8 || strcmp(currentObjectGroup, irisGroup))
 	{
 		IRIS_StackPop(3);
 		IRIS_StackPush(NULL);
@@ -945,29 +964,22 @@ void __store_objects(void)
 /*	{
 		char keycode;
 		char tempBuf[2000];
-		sprintf(tempBuf, "size => %d ", strlen(objects));
+		sprintf(tempBuf, "size => %d ", size);
 		write_at(tempBuf, strlen(tempBuf), 1, 1);
 		while(read(STDIN, &keycode, 1) != 1);
 	}
 */
-	// Convert from string to hex
-	size = strlen(objects)/2;
-	objects_hex = my_calloc(size + 1);
-	UtilStringToHex(objects, strlen(objects), (unsigned char *) objects_hex);
-	IRIS_StackPop(1);
-	objects = objects_hex + 8;
-	size -= 8;
-	outSize = atol(objects_hex);
-
-	// Decompress the objects first
-	objects = (char *) decompress((unsigned char *) objects, outSize, size);
-	my_free(objects_hex);
+	// The first 8 bytes hold the decompressed size as text. It is not needed as the objects are inflated as they are framed
+	streamStart(&stream, (unsigned char *) objects_hex + 8, size - 8);
 
-	// Get one object at a time
-	for (index = 0; (length = getNextObject(objects, &index, strlen(objects))) != 0; index += length, count++)
+	// Get one object at a time. The window may move when it grows so the objects pointer is refreshed for each object
+	for (index = 0; (length = streamNextObject(&stream, &index)) != 0; index += length, count++)
 	{
 		// Get the object type
-		char * type = IRIS_GetStringValue(&objects[index], length, "TYPE", false);
+		char * type;
+
+		objects = stream.window;
+		type = IRIS_GetStringValue(&objects[index], length, "TYPE", false);
 
 		// If type does not exist, reject the object
 		if (type == NULL)
@@ -976,79 +988,21 @@ void __store_objects(void)
 		// If type is a display object, then authenticate the signature of the file
 		if (strcmp(&type[4], "DISPLAY") == 0 || strcmp(&type[4], "TEXT TABLE") == 0 || strcmp(&type[4], "IMAGE") == 0 || strcmp(&type[4], "PROFILE") == 0)
 		{
-			char sign[40];
-			char * ptr;
-
-			// Store character after object in a safe place. We are about to change it to NULL to manipulate this a sa string.
 			char keep = objects[index+length];
+			bool sign;
 
-			// Change object to a null terminated string.
+			// If the signature does not exist, discard the object. The object is null terminated for the search only
 			objects[index+length] = '\0';
+			sign = (bool) (strstr(&objects[index], "SIGN:") != NULL);
+			objects[index+length] = keep;
 
-/*	{
-		char keycode;
-		char tempBuf[2000];
-		sprintf(tempBuf, "step 1 ");
-		write_at(tempBuf, strlen(tempBuf), 1, 1);
-		while(read(STDIN, &keycode, 1) != 1);
-	}
-*/
-			// If signature does not exist, disacard objects
-			if ((ptr = strstr(&objects[index], "SIGN:")) != NULL)
-			{
-				int myStackIndex = stackIndex;
-				stackLevel++;
-
-/*	{
-		char keycode;
-		char tempBuf[2000];
-		sprintf(tempBuf, "step 2 ");
-		write_at(tempBuf, strlen(tempBuf), 1, 1);
-		while(read(STDIN, &keycode, 1) != 1);
-	}
-*/
-				// Replace signature with ZEROS keeping it safe.
-				memcpy(sign, ptr+5, sizeof(sign));
-				memcpy(ptr+5, "0000000000000000000000000000000000000000", sizeof(sign));
-
-				// Encrypt using iRIS secret key
-				SecuritySetIV(NULL);
-				IRIS_StackPushFunc("()ENC");
-				IRIS_StackPush(sk);			// Key location
-				IRIS_StackPush(NULL);		// 16 byte double length
-
-				// Calculate SHA-1. Result is the data for encryption
-				IRIS_StackPushFunc("()SHA1");
-				IRIS_StackPushFunc("()TO_AHEX");
-				IRIS_StackPush(&objects[index]);
-
-/*	{
-		char keycode;
-		char tempBuf[2000];
-		sprintf(tempBuf, "step 3 %X ", IRIS_StackGet(0));
-		write_at(tempBuf, strlen(tempBuf), 1, 1);
-		while(read(STDIN, &keycode, 1) != 1);
-	}
-*/
-				// If SHA-1 does not match
+			// If the signature does not match, discard the object
 #ifndef __UNSIGNED
-				if (memcmp(IRIS_StackGet(0), sign, sizeof(sign)) == 0)
+			if (sign)
+				sign = IRIS_VerifyObjectSignature(&objects[index], length, sk);
 #endif
-				{
-					// Reinsert the correct sign in the object
-					memcpy(ptr+5, sign, sizeof(sign));
-
-					// Store the object
-					IRIS_PutObjectData(&objects[index], length);
-				}
-
-				// House keep
-				IRIS_StackPop(stackIndex - myStackIndex);
-				stackLevel--;
-			}
-
-			// Restore the keep character
-			objects[index+length] = keep;
+			if (sign)
+				IRIS_PutObjectData(&objects[index], length);
 		}
 
 		// If this is a configuration or data object, store it without further authentication. It is not executable.
@@ -1069,7 +1023,7 @@ void __store_objects(void)
 			if ((objectName = IRIS_GetStringValue(&objects[index], length, "NAME", false)) != NULL)
 			{
 				if (objectName[0] == '\0')
-					_remove(&objectName[4]);
+					IRIS_RemoveObject(&objectName[4]);
 				IRIS_DeallocateStringValue(objectName);
 			}
 
@@ -1095,14 +1049,14 @@ void __store_objects(void)
 							strcpy(oldFileName, j?"I:":"F:");
 							for (i = dir_get_first(fileName); i == 0; i = dir_get_next(fileName))
 							{
-								if ((data = IRIS_GetObjectData(fileName, &len)) != NULL)
+								if ((data = IRIS_LoadObjectData(fileName, &len)) != NULL)
 								{
 									if (data[0] == '{' && data[len-1] == '}' && (ptr = strstr(data, &groupName[4])) != NULL &&
 										(ptr[-1] == ',' || ptr[-1] == '{') && strncmp(&ptr[strlen(&groupName[4])+1], &groupValue[4], strlen(&groupValue[4])) == 0 &&
 										(groupType == NULL || groupType[0] != '\0' || ((ptr = strstr(data, "TYPE:")) != NULL &&
 										(ptr[-1] == ',' || ptr[-1] == '{') && strncmp(&ptr[5], &groupType[4], strlen(&groupType[4])) == 0)))
 									{
-										_remove(fileName);
+										IRIS_RemoveObject(fileName);
 										strcpy(fileName, oldFileName);
 									}
 									else strcpy(oldFileName, fileName);
@@ -1217,6 +1171,7 @@ void __store_objects(void)
 #endif
 
 						my_free(hexData);
+						IRIS_InvalidateObjectCache(&fileName[4]);
 					}
 
 					IRIS_DeallocateStringValue(fileData);
@@ -1320,6 +1275,7 @@ void __store_objects(void)
 						}
 					}
 #endif
+					IRIS_InvalidateObjectCache(&fileName[4]);
 					IRIS_DeallocateStringValue(fileMax);
 				}
 
@@ -1331,9 +1287,8 @@ void __store_objects(void)
 		IRIS_DeallocateStringValue(type);
 	}
 
-	my_free(objects);
-//	my_free(objects_hex);
-	IRIS_StackPop(2);
+	streamStop(&stream);
+	IRIS_StackPop(3);
 	sprintf(temp, "%d", count);
 	IRIS_StackPush(temp);
 }
@@ -1483,6 +1438,26 @@ void __remote(void)
 	IRIS_StackPop(1);
 }
 
+//
+//-------------------------------------------------------------------------------------------
+// FUNCTION   : ()SYNC
+//
+// DESCRIPTION:	Initiate a remote session that brings all the objects up to date in one go
+//
+// PARAMETERS:	None
+//
+// RETURNS:		None
+//-------------------------------------------------------------------------------------------
+//
+void __sync(void)
+{
+	// Use the system utility to do so.
+	IRIS_SyncObjects();
+
+	// Lose the function name
+	IRIS_StackPop(1);
+}
+
 
 //
 //-------------------------------------------------------------------------------------------
@@ -1634,14 +1609,13 @@ void __new_event_value(void)
 void __clr_tmp(void)
 {
 	int count;
-	char temp[50];
 	char * objectName = IRIS_StackGet(0);
 
 
 	count = IRIS_ClrTemp((objectName && objectName[0])? objectName:currentObject);
 
 	IRIS_StackPop(2);
-	IRIS_StackPush(ltoa(count, temp, 10));
+	IRIS_StackPushNumber(count);
 }
 
 //
@@ -1705,7 +1679,7 @@ void __battery_status(void)
 {
 #ifndef __VX670
 	IRIS_StackPop(1);
-	IRIS_StackPush("OK");
+	IRIS_StackPushConst("OK");
 #else
 	int status = get_battery_sts();
 
@@ -1729,7 +1703,7 @@ void __dock_status(void)
 {
 #ifndef __VX670
 	IRIS_StackPop(1);
-	IRIS_StackPush("OK");
+	IRIS_StackPushConst("OK");
 #else
 	int dock = get_dock_sts();
 